@@ -0,0 +1,372 @@
+#pragma once
+#include "array_ptr.h"
+#include "simple_vector.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Ниже этого размера поразрядная сортировка проигрывает std::sort
+inline constexpr size_t kRadixSortThreshold = 256;
+// Ниже этого размера сортировка слиянием не распараллеливается
+inline constexpr size_t kParallelSortThreshold = size_t{1} << 16;
+
+// Описывает, как отобразить значение типа Type в беззнаковый ключ того же размера,
+// порядок которого совпадает с порядком исходных значений.
+// Для типов без такого отображения поразрядная сортировка недоступна
+template <typename Type, typename = void>
+struct RadixKey {
+    static constexpr bool enabled = false;
+};
+
+template <typename Type>
+struct RadixKey<Type, std::enable_if_t<std::is_integral_v<Type> && !std::is_same_v<Type, bool>>> {
+    static constexpr bool enabled = true;
+    using Key = std::make_unsigned_t<Type>;
+
+    static Key ToKey(Type value) noexcept {
+        // У знаковых чисел инвертируем знаковый бит, чтобы отрицательные шли первыми
+        constexpr Key sign_flip = std::is_signed_v<Type> ? Key(Key(1) << (sizeof(Key) * 8 - 1)) : Key(0);
+        return static_cast<Key>(static_cast<Key>(value) ^ sign_flip);
+    }
+};
+
+template <typename Type>
+struct RadixKey<Type, std::enable_if_t<std::is_floating_point_v<Type> && (sizeof(Type) == 4 || sizeof(Type) == 8)>> {
+    static constexpr bool enabled = true;
+    using Key = std::conditional_t<sizeof(Type) == 4, uint32_t, uint64_t>;
+
+    // -0.0 оказывается перед +0.0, NaN со знаком минус - в начале, остальные NaN - в конце
+    static Key ToKey(Type value) noexcept {
+        constexpr Key sign_bit = Key(1) << (sizeof(Key) * 8 - 1);
+        Key bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (bits & sign_bit) ? static_cast<Key>(~bits) : static_cast<Key>(bits | sign_bit);
+    }
+};
+
+// Вспомогательный буфер для сортировок.
+// Память выделяется только при росте запрошенного размера,
+// поэтому один буфер можно переиспользовать между вызовами
+template <typename Type>
+class SortBuffer {
+public:
+    SortBuffer() = default;
+
+    // Возвращает указатель на буфер из не менее чем size элементов
+    Type* Acquire(size_t size) {
+        if (size > capacity_) {
+            ArrayPtr<Type> new_buffer(size);
+            buffer_.swap(new_buffer);
+            capacity_ = size;
+        }
+        return buffer_.Get();
+    }
+
+    size_t GetCapacity() const noexcept {
+        return capacity_;
+    }
+
+private:
+    ArrayPtr<Type> buffer_;
+    size_t capacity_ = 0;
+};
+
+namespace detail {
+
+// LSD-сортировка по байтам ключа. Устойчива.
+// Гистограммы всех разрядов строятся за один проход,
+// разряды, в которых все ключи совпадают, пропускаются
+template <typename Type>
+void RadixSort(Type* first, Type* last, Type* buffer) {
+    using Traits = RadixKey<Type>;
+    using Key = typename Traits::Key;
+    constexpr size_t kPasses = sizeof(Key);
+
+    const size_t size = static_cast<size_t>(last - first);
+    size_t counts[kPasses][256] = {};
+    for (Type* it = first; it != last; ++it) {
+        const Key key = Traits::ToKey(*it);
+        for (size_t pass = 0; pass < kPasses; ++pass) {
+            ++counts[pass][(key >> (pass * 8)) & 0xFF];
+        }
+    }
+
+    Type* src = first;
+    Type* dst = buffer;
+    for (size_t pass = 0; pass < kPasses; ++pass) {
+        size_t* count = counts[pass];
+        const Key first_byte = (Traits::ToKey(*first) >> (pass * 8)) & 0xFF;
+        if (count[first_byte] == size) {
+            continue;
+        }
+        size_t offset = 0;
+        for (size_t byte = 0; byte < 256; ++byte) {
+            const size_t current = count[byte];
+            count[byte] = offset;
+            offset += current;
+        }
+        for (Type* it = src; it != src + size; ++it) {
+            dst[count[(Traits::ToKey(*it) >> (pass * 8)) & 0xFF]++] = std::move(*it);
+        }
+        std::swap(src, dst);
+    }
+    if (src != first) {
+        std::move(src, src + size, first);
+    }
+}
+
+// Устойчивое слияние соседних диапазонов [first, middle) и [middle, last).
+// Левая половина переносится в buffer, результат пишется поверх first
+template <typename Type, typename Compare>
+void MergeWithBuffer(Type* first, Type* middle, Type* last, Type* buffer, Compare comp) {
+    Type* buffer_end = std::move(first, middle, buffer);
+    Type* left = buffer;
+    Type* right = middle;
+    Type* out = first;
+    while (left != buffer_end && right != last) {
+        if (comp(*right, *left)) {
+            *out++ = std::move(*right++);
+        } else {
+            *out++ = std::move(*left++);
+        }
+    }
+    std::move(left, buffer_end, out);
+}
+
+// Устойчивая сортировка вставками для коротких участков
+template <typename Type, typename Compare>
+void InsertionSort(Type* first, Type* last, Compare comp) {
+    if (first == last) {
+        return;
+    }
+    for (Type* it = first + 1; it != last; ++it) {
+        Type value = std::move(*it);
+        Type* hole = it;
+        for (; hole != first && comp(value, *(hole - 1)); --hole) {
+            *hole = std::move(*(hole - 1));
+        }
+        *hole = std::move(value);
+    }
+}
+
+// Участки не длиннее этого сортируются вставками
+inline constexpr size_t kInsertionSortThreshold = 32;
+
+// Устойчивая сортировка слиянием, которая берёт временную память из buffer
+// (не менее size / 2 элементов) вместо того, чтобы выделять её, как std::stable_sort
+template <typename Type, typename Compare>
+void BufferedMergeSort(Type* first, Type* last, Type* buffer, Compare comp) {
+    const size_t size = static_cast<size_t>(last - first);
+    if (size <= kInsertionSortThreshold) {
+        InsertionSort(first, last, comp);
+        return;
+    }
+    Type* middle = first + size / 2;
+    BufferedMergeSort(first, middle, buffer, comp);
+    BufferedMergeSort(middle, last, buffer, comp);
+    if (comp(*middle, *(middle - 1))) {
+        MergeWithBuffer(first, middle, last, buffer, comp);
+    }
+}
+
+// Сортировка слиянием, половины которой сортируются в отдельных потоках,
+// пока не исчерпана глубина depth. Каждая половина использует свою часть buffer.
+// Компаратор не должен выбрасывать исключений
+template <typename Type, typename Compare>
+void ParallelMergeSort(Type* first, Type* last, Type* buffer, Compare comp, unsigned depth) {
+    const size_t size = static_cast<size_t>(last - first);
+    if (depth == 0 || size < kParallelSortThreshold) {
+        BufferedMergeSort(first, last, buffer, comp);
+        return;
+    }
+    Type* middle = first + size / 2;
+    std::thread left_worker;
+    try {
+        left_worker = std::thread([=] {
+            ParallelMergeSort(first, middle, buffer, comp, depth - 1);
+        });
+    } catch (const std::system_error&) {
+        // Потоков не хватило: левая половина сортируется в текущем потоке
+        ParallelMergeSort(first, middle, buffer, comp, depth - 1);
+    }
+    // Разрушение незавершённого std::thread вызывает std::terminate,
+    // поэтому рабочий поток дожидается и при исключении
+    try {
+        ParallelMergeSort(middle, last, buffer + size / 2, comp, depth - 1);
+    } catch (...) {
+        if (left_worker.joinable()) {
+            left_worker.join();
+        }
+        throw;
+    }
+    if (left_worker.joinable()) {
+        left_worker.join();
+    }
+    MergeWithBuffer(first, middle, last, buffer, comp);
+}
+
+inline unsigned ParallelSortDepth() {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned depth = 0;
+    while ((1u << depth) < threads) {
+        ++depth;
+    }
+    return depth;
+}
+
+// Бинарный поиск без ветвлений: на каждом шаге выбирается только смещение,
+// что компилируется в cmov вместо плохо предсказуемого перехода
+template <typename Type, typename Value, typename Compare>
+const Type* BranchlessLowerBound(const Type* first, size_t size, const Value& value, Compare comp) {
+    if (size == 0) {
+        return first;
+    }
+    while (size > 1) {
+        const size_t half = size / 2;
+        first = comp(first[half], value) ? first + half : first;
+        size -= half;
+    }
+    return first + (comp(*first, value) ? 1 : 0);
+}
+
+// Потоковое сжатие: оставляет items[i], для которых mask[i] != 0.
+// Запись идёт без ветвлений, а при наличии AVX-512 - блоками по 64 байта
+// инструкцией compress-store. Возвращает количество оставшихся элементов
+template <typename Type>
+size_t CompactByMask(Type* items, const uint8_t* mask, size_t size) {
+    size_t read = 0;
+    size_t write = 0;
+#if defined(__AVX512F__)
+    if constexpr (sizeof(Type) == 4) {
+        for (; read + 16 <= size; read += 16) {
+            const __m512i keep = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + read)));
+            const __mmask16 lanes = _mm512_test_epi32_mask(keep, keep);
+            const __m512i values = _mm512_loadu_si512(items + read);
+            _mm512_mask_compressstoreu_epi32(items + write, lanes, values);
+            write += static_cast<size_t>(__builtin_popcount(lanes));
+        }
+    } else if constexpr (sizeof(Type) == 8) {
+        for (; read + 8 <= size; read += 8) {
+            const __m512i keep = _mm512_cvtepu8_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask + read)));
+            const __mmask8 lanes = _mm512_test_epi64_mask(keep, keep);
+            const __m512i values = _mm512_loadu_si512(items + read);
+            _mm512_mask_compressstoreu_epi64(items + write, lanes, values);
+            write += static_cast<size_t>(__builtin_popcount(lanes));
+        }
+    }
+#endif
+    for (; read < size; ++read) {
+        items[write] = items[read];
+        write += mask[read] != 0 ? 1 : 0;
+    }
+    return write;
+}
+
+}  // namespace detail
+
+// Сортирует вектор по возрастанию.
+// Целые числа и числа с плавающей точкой сортируются поразрядно с использованием buffer
+template <typename Type>
+void Sort(SimpleVector<Type>& vector, SortBuffer<Type>& buffer) {
+    const size_t size = vector.GetSize();
+    if constexpr (RadixKey<Type>::enabled) {
+        if (size >= kRadixSortThreshold) {
+            Span<Type> items = vector;
+            detail::RadixSort(items.begin(), items.end(), buffer.Acquire(size));
+            return;
+        }
+    }
+    std::sort(vector.begin(), vector.end());
+}
+
+template <typename Type>
+void Sort(SimpleVector<Type>& vector) {
+    SortBuffer<Type> buffer;
+    Sort(vector, buffer);
+}
+
+template <typename Type, typename Compare>
+void Sort(SimpleVector<Type>& vector, Compare comp) {
+    std::sort(vector.begin(), vector.end(), comp);
+}
+
+// Сортирует вектор, сохраняя относительный порядок равных элементов.
+// Большие векторы без поразрядного ключа сортируются параллельным слиянием
+template <typename Type, typename Compare>
+void StableSort(SimpleVector<Type>& vector, Compare comp, SortBuffer<Type>& buffer) {
+    const size_t size = vector.GetSize();
+    Span<Type> items = vector;
+    if (size < kParallelSortThreshold) {
+        detail::BufferedMergeSort(items.begin(), items.end(), buffer.Acquire(size / 2), comp);
+        return;
+    }
+    detail::ParallelMergeSort(items.begin(), items.end(), buffer.Acquire(size), comp, detail::ParallelSortDepth());
+}
+
+template <typename Type, typename Compare>
+void StableSort(SimpleVector<Type>& vector, Compare comp) {
+    SortBuffer<Type> buffer;
+    StableSort(vector, comp, buffer);
+}
+
+template <typename Type>
+void StableSort(SimpleVector<Type>& vector, SortBuffer<Type>& buffer) {
+    if constexpr (RadixKey<Type>::enabled) {
+        // Поразрядная сортировка устойчива сама по себе
+        Sort(vector, buffer);
+    } else {
+        StableSort(vector, std::less<Type>{}, buffer);
+    }
+}
+
+template <typename Type>
+void StableSort(SimpleVector<Type>& vector) {
+    SortBuffer<Type> buffer;
+    StableSort(vector, buffer);
+}
+
+// Переставляет элементы так, что на позиции nth оказывается элемент,
+// который стоял бы там после сортировки, слева - не большие, справа - не меньшие
+template <typename Type, typename Compare = std::less<Type>>
+void NthElement(SimpleVector<Type>& vector, size_t nth, Compare comp = Compare{}) {
+    assert(nth <= vector.GetSize());
+    std::nth_element(vector.begin(), vector.begin() + nth, vector.end(), comp);
+}
+
+// Возвращает итератор на первый элемент отсортированного вектора, не меньший value
+template <typename Type, typename Value, typename Compare = std::less<>>
+typename SimpleVector<Type>::ConstIterator LowerBound(const SimpleVector<Type>& vector, const Value& value,
+                                                      Compare comp = Compare{}) {
+    ConstSpan<Type> items = vector;
+    const Type* found = detail::BranchlessLowerBound(items.GetData(), items.GetSize(), value, comp);
+    return vector.begin() + (found - items.GetData());
+}
+
+template <typename Type, typename Value, typename Compare = std::less<>>
+typename SimpleVector<Type>::Iterator LowerBound(SimpleVector<Type>& vector, const Value& value,
+                                                 Compare comp = Compare{}) {
+    const auto& const_vector = vector;
+    return vector.begin() + (LowerBound(const_vector, value, comp) - const_vector.begin());
+}
+
+// Оставляет в векторе элементы, для которых keep_mask[i] != 0, сохраняя их порядок.
+// Предназначена для чисел, у которых маска посчитана заранее, например векторно.
+// Возвращает количество удалённых элементов
+template <typename Type>
+size_t CompactByMask(SimpleVector<Type>& vector, ConstSpan<uint8_t> keep_mask) {
+    static_assert(std::is_arithmetic_v<Type>, "CompactByMask supports only arithmetic types");
+    assert(keep_mask.GetSize() == vector.GetSize());
+    Span<Type> items = vector;
+    const size_t kept = detail::CompactByMask(items.GetData(), keep_mask.GetData(), items.GetSize());
+    vector.Resize(kept);
+    return items.GetSize() - kept;
+}
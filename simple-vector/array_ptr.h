@@ -1,24 +1,40 @@
+#pragma once
 #include <cstdlib>
+#include <utility>
+
+// Начиная с C++20 выделение памяти допустимо в constexpr-вычислениях,
+// если она освобождается в том же вычислении. Тогда ArrayPtr и SimpleVector
+// можно использовать для построения таблиц на этапе компиляции
+#if defined(__cpp_constexpr_dynamic_alloc) && __cpp_constexpr_dynamic_alloc >= 201907L
+#define SIMPLE_VECTOR_CONSTEXPR constexpr
+#else
+#define SIMPLE_VECTOR_CONSTEXPR
+#endif
 
 template <typename Type>
 class ArrayPtr {
 public:
+    // Функция освобождения чужого буфера. context передаётся ей без изменений
+    using Deleter = void (*)(Type* raw_ptr, void* context);
+
     // Инициализирует ArrayPtr нулевым указателем
     ArrayPtr() = default;
 
     // Создаёт в куче массив из size элементов типа Type.
     // Если size == 0, поле raw_ptr_ должно быть равно nullptr
-    explicit ArrayPtr(size_t size) {
+    SIMPLE_VECTOR_CONSTEXPR explicit ArrayPtr(size_t size) {
         // Реализуйте конструктор самостоятельно
         if(size != 0){
             raw_ptr_ = new Type[size];
         }
     }
-    ArrayPtr(ArrayPtr&& array) {
+    SIMPLE_VECTOR_CONSTEXPR ArrayPtr(ArrayPtr&& array) {
         raw_ptr_ = std::exchange(array.raw_ptr_, nullptr);
+        deleter_ = std::exchange(array.deleter_, nullptr);
+        context_ = std::exchange(array.context_, nullptr);
     }
     // Конструктор из сырого указателя, хранящего адрес массива в куче либо nullptr
-    explicit ArrayPtr(Type* raw_ptr) noexcept {
+    SIMPLE_VECTOR_CONSTEXPR explicit ArrayPtr(Type* raw_ptr) noexcept {
         // Реализуйте конструктор самостоятельно
         if (raw_ptr)
         {
@@ -26,61 +42,95 @@ public:
         }
     }
 
+    // Принимает во владение внешний буфер (например, полученный при вводе-выводе)
+    // без копирования. При разрушении вместо delete[] вызывается deleter(raw_ptr, context).
+    // Если deleter == nullptr, буфер не освобождается: ArrayPtr лишь ссылается на него
+    SIMPLE_VECTOR_CONSTEXPR ArrayPtr(Type* raw_ptr, Deleter deleter, void* context = nullptr) noexcept
+        : raw_ptr_(raw_ptr)
+        , deleter_(deleter ? deleter : &NoDelete)
+        , context_(context) {
+    }
+
     // Запрещаем копирование
     ArrayPtr(const ArrayPtr&) = delete;
 
-    ~ArrayPtr() {
-        delete[] raw_ptr_;
+    SIMPLE_VECTOR_CONSTEXPR ~ArrayPtr() {
+        Free();
         raw_ptr_ = nullptr;
     }
 
     // Запрещаем присваивание
     ArrayPtr& operator=(const ArrayPtr&) = delete;
 
-    ArrayPtr& operator=(ArrayPtr&& array) {
+    SIMPLE_VECTOR_CONSTEXPR ArrayPtr& operator=(ArrayPtr&& array) {
         if(this != &array){
-            std::swap(raw_ptr_,array.raw_ptr_);
+            swap(array);
         }
         return *this;
     }
     // Прекращает владением массивом в памяти, возвращает значение адреса массива
     // После вызова метода указатель на массив должен обнулиться
-    [[nodiscard]] Type* Release() noexcept {
+    // Для внешнего буфера освобождать его дальше должен вызывающий (см. IsAdopted)
+    [[nodiscard]] SIMPLE_VECTOR_CONSTEXPR Type* Release() noexcept {
         // Заглушка. Реализуйте метод самостоятельно
         Type* array_ptr = raw_ptr_;
         raw_ptr_ = nullptr;
+        deleter_ = nullptr;
+        context_ = nullptr;
         return array_ptr;
     }
 
+    // Возвращает true, если буфер получен извне и освобождается собственным deleter
+    SIMPLE_VECTOR_CONSTEXPR bool IsAdopted() const noexcept {
+        return deleter_ != nullptr;
+    }
+
     // Возвращает ссылку на элемент массива с индексом index
-    Type& operator[](size_t index) noexcept {
+    SIMPLE_VECTOR_CONSTEXPR Type& operator[](size_t index) noexcept {
         return *(raw_ptr_ + index);
     }
 
     // Возвращает константную ссылку на элемент массива с индексом index
-    const Type& operator[](size_t index) const noexcept {
+    SIMPLE_VECTOR_CONSTEXPR const Type& operator[](size_t index) const noexcept {
         return *(raw_ptr_ + index);
     }
 
     // Возвращает true, если указатель ненулевой, и false в противном случае
-    explicit operator bool() const {
+    SIMPLE_VECTOR_CONSTEXPR explicit operator bool() const {
         // Заглушка. Реализуйте операцию самостоятельно
         return raw_ptr_ != nullptr;
     }
 
     // Возвращает значение сырого указателя, хранящего адрес начала массива
-    Type* Get() const noexcept {
+    SIMPLE_VECTOR_CONSTEXPR Type* Get() const noexcept {
         // Заглушка. Реализуйте метод самостоятельно
         return raw_ptr_;
     }
 
     // Обменивается значениям указателя на массив с объектом other
-    void swap(ArrayPtr& other) noexcept {
-        Type * tmp = other.raw_ptr_;
+    SIMPLE_VECTOR_CONSTEXPR void swap(ArrayPtr& other) noexcept {
         std::swap(other.raw_ptr_, this->raw_ptr_);
-        
+        std::swap(other.deleter_, this->deleter_);
+        std::swap(other.context_, this->context_);
     }
 
 private:
+    static void NoDelete(Type*, void*) noexcept {
+    }
+
+    SIMPLE_VECTOR_CONSTEXPR void Free() noexcept {
+        if (deleter_)
+        {
+            deleter_(raw_ptr_, context_);
+        }
+        else
+        {
+            delete[] raw_ptr_;
+        }
+    }
+
     Type* raw_ptr_ = nullptr;
+    // nullptr означает, что массив выделен через new[] самим ArrayPtr
+    Deleter deleter_ = nullptr;
+    void* context_ = nullptr;
 };
\ No newline at end of file
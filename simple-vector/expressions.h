@@ -0,0 +1,294 @@
+#pragma once
+#include "array_ptr.h"
+#include "simple_vector.h"
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+
+// Ниже этого размера ленивое выражение вычисляется в одном потоке
+inline constexpr size_t kParallelEvaluateThreshold = size_t{1} << 18;
+
+namespace detail {
+
+template <typename Expression, typename OutType>
+void EvaluateRange(const Expression& expression, OutType* out, size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+        out[i] = static_cast<OutType>(expression[i]);
+    }
+}
+
+// Записывает значения выражения в out[0, GetSize()), разбив работу на threads частей:
+// первая вычисляется в текущем потоке, остальные - в рабочих потоках
+template <typename Expression, typename OutType>
+void EvaluateInto(const Expression& expression, OutType* out, unsigned threads) {
+    const size_t size = expression.GetSize();
+    if (threads <= 1) {
+        EvaluateRange(expression, out, 0, size);
+        return;
+    }
+    const size_t chunk = (size + threads - 1) / threads;
+    ArrayPtr<std::thread> workers(threads - 1);
+    ArrayPtr<std::exception_ptr> errors(threads - 1);
+    size_t started = 0;
+    for (; started + 1 < threads; ++started) {
+        const size_t first = (started + 1) * chunk;
+        std::exception_ptr* error = &errors[started];
+        try {
+            workers[started] = std::thread([&expression, out, first, chunk, size, error] {
+                try {
+                    EvaluateRange(expression, out, std::min(first, size), std::min(first + chunk, size));
+                } catch (...) {
+                    *error = std::current_exception();
+                }
+            });
+        } catch (const std::system_error&) {
+            // Потоков не хватило: оставшиеся части вычисляются в текущем потоке
+            break;
+        }
+    }
+    // Разрушение незавершённого std::thread вызывает std::terminate,
+    // поэтому запущенные потоки дожидаются и при исключении
+    auto join_workers = [&workers, started] {
+        for (size_t i = 0; i < started; ++i) {
+            workers[i].join();
+        }
+    };
+    try {
+        EvaluateRange(expression, out, 0, std::min(chunk, size));
+        EvaluateRange(expression, out, std::min((started + 1) * chunk, size), size);
+    } catch (...) {
+        join_workers();
+        throw;
+    }
+    join_workers();
+    for (size_t i = 0; i < started; ++i) {
+        if (errors[i]) {
+            std::rethrow_exception(errors[i]);
+        }
+    }
+}
+
+}  // namespace detail
+
+// Базовый класс ленивых поэлементных выражений над SimpleVector.
+// Наследник обязан предоставить GetSize() и operator[](index).
+// Выражение вычисляется одним проходом при присваивании в SimpleVector,
+// промежуточные векторы не создаются
+template <typename Derived>
+class VectorExpression {
+public:
+    // Признак, по которому SimpleVector распознаёт выражение
+    using VectorExpressionTag = void;
+
+    const Derived& Self() const noexcept {
+        return static_cast<const Derived&>(*this);
+    }
+
+    // Записывает значения выражения в out[0, GetSize()).
+    // При parallel == true большие выражения делятся между всеми ядрами
+    template <typename OutType>
+    void EvaluateInto(OutType* out, bool parallel = false) const {
+        const bool split = parallel && Self().GetSize() >= kParallelEvaluateThreshold;
+        const unsigned threads = split ? std::max(1u, std::thread::hardware_concurrency()) : 1u;
+        detail::EvaluateInto(Self(), out, threads);
+    }
+};
+
+// Лист выражения: ссылка на элементы существующего вектора
+template <typename Type>
+class VectorReference : public VectorExpression<VectorReference<Type>> {
+public:
+    static constexpr bool kIsScalar = false;
+
+    explicit VectorReference(const SimpleVector<Type>& vector) noexcept
+        : data_(vector.AsSpan().GetData())
+        , size_(vector.GetSize()) {
+    }
+
+    size_t GetSize() const noexcept {
+        return size_;
+    }
+
+    const Type& operator[](size_t index) const noexcept {
+        return data_[index];
+    }
+
+private:
+    const Type* data_;
+    size_t size_;
+};
+
+// Лист выражения: скаляр, размноженный на все позиции
+template <typename Type>
+class ScalarExpression {
+public:
+    static constexpr bool kIsScalar = true;
+
+    explicit ScalarExpression(Type value) noexcept
+        : value_(value) {
+    }
+
+    Type operator[](size_t) const noexcept {
+        return value_;
+    }
+
+private:
+    Type value_;
+};
+
+template <typename Lhs, typename Rhs, typename Op>
+class BinaryExpression : public VectorExpression<BinaryExpression<Lhs, Rhs, Op>> {
+public:
+    static constexpr bool kIsScalar = false;
+
+    BinaryExpression(Lhs lhs, Rhs rhs, Op op)
+        : lhs_(lhs)
+        , rhs_(rhs)
+        , op_(op) {
+        if constexpr (!Lhs::kIsScalar && !Rhs::kIsScalar) {
+            assert(lhs_.GetSize() == rhs_.GetSize());
+        }
+    }
+
+    size_t GetSize() const noexcept {
+        if constexpr (Lhs::kIsScalar) {
+            return rhs_.GetSize();
+        } else {
+            return lhs_.GetSize();
+        }
+    }
+
+    auto operator[](size_t index) const {
+        return op_(lhs_[index], rhs_[index]);
+    }
+
+private:
+    Lhs lhs_;
+    Rhs rhs_;
+    Op op_;
+};
+
+template <typename Operand, typename Func>
+class MapExpression : public VectorExpression<MapExpression<Operand, Func>> {
+public:
+    static constexpr bool kIsScalar = false;
+
+    MapExpression(Operand operand, Func func)
+        : operand_(operand)
+        , func_(func) {
+    }
+
+    size_t GetSize() const noexcept {
+        return operand_.GetSize();
+    }
+
+    auto operator[](size_t index) const {
+        return func_(operand_[index]);
+    }
+
+private:
+    Operand operand_;
+    Func func_;
+};
+
+namespace detail {
+
+template <typename T>
+struct IsSimpleVector : std::false_type {};
+
+template <typename Type>
+struct IsSimpleVector<SimpleVector<Type>> : std::true_type {};
+
+template <typename T, typename = void>
+struct IsVectorExpression : std::false_type {};
+
+template <typename T>
+struct IsVectorExpression<T, std::void_t<typename T::VectorExpressionTag>> : std::true_type {};
+
+template <typename T>
+inline constexpr bool kIsVectorLike = IsSimpleVector<T>::value || IsVectorExpression<T>::value;
+
+// Оператор подходит, если оба операнда - векторы, выражения или числа
+// и хотя бы один из них не число
+template <typename Lhs, typename Rhs>
+inline constexpr bool kIsExpressionOperands =
+    (kIsVectorLike<Lhs> || std::is_arithmetic_v<Lhs>) && (kIsVectorLike<Rhs> || std::is_arithmetic_v<Rhs>) &&
+    (kIsVectorLike<Lhs> || kIsVectorLike<Rhs>);
+
+template <typename T>
+auto ToOperand(const T& value) {
+    if constexpr (IsSimpleVector<T>::value) {
+        return VectorReference(value);
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        return ScalarExpression<T>(value);
+    } else {
+        return value;
+    }
+}
+
+template <typename Lhs, typename Rhs, typename Op>
+auto MakeBinary(const Lhs& lhs, const Rhs& rhs, Op op) {
+    auto lhs_operand = ToOperand(lhs);
+    auto rhs_operand = ToOperand(rhs);
+    return BinaryExpression<decltype(lhs_operand), decltype(rhs_operand), Op>(lhs_operand, rhs_operand, op);
+}
+
+}  // namespace detail
+
+template <typename Lhs, typename Rhs, typename = std::enable_if_t<detail::kIsExpressionOperands<Lhs, Rhs>>>
+auto operator+(const Lhs& lhs, const Rhs& rhs) {
+    return detail::MakeBinary(lhs, rhs, std::plus<>{});
+}
+
+template <typename Lhs, typename Rhs, typename = std::enable_if_t<detail::kIsExpressionOperands<Lhs, Rhs>>>
+auto operator-(const Lhs& lhs, const Rhs& rhs) {
+    return detail::MakeBinary(lhs, rhs, std::minus<>{});
+}
+
+template <typename Lhs, typename Rhs, typename = std::enable_if_t<detail::kIsExpressionOperands<Lhs, Rhs>>>
+auto operator*(const Lhs& lhs, const Rhs& rhs) {
+    return detail::MakeBinary(lhs, rhs, std::multiplies<>{});
+}
+
+template <typename Lhs, typename Rhs, typename = std::enable_if_t<detail::kIsExpressionOperands<Lhs, Rhs>>>
+auto operator/(const Lhs& lhs, const Rhs& rhs) {
+    return detail::MakeBinary(lhs, rhs, std::divides<>{});
+}
+
+// Лениво применяет func к каждому элементу вектора или выражения
+template <typename Operand, typename Func, typename = std::enable_if_t<detail::kIsVectorLike<Operand>>>
+auto Map(const Operand& operand, Func func) {
+    auto wrapped = detail::ToOperand(operand);
+    return MapExpression<decltype(wrapped), Func>(wrapped, func);
+}
+
+// Сумма элементов вектора или выражения.
+// Четыре независимых аккумулятора разрывают цепочку зависимостей сложений
+template <typename Operand, typename = std::enable_if_t<detail::kIsVectorLike<Operand>>>
+auto Sum(const Operand& operand) {
+    const auto wrapped = detail::ToOperand(operand);
+    using Value = std::decay_t<decltype(wrapped[0])>;
+    const size_t size = wrapped.GetSize();
+    Value acc[4] = {Value(), Value(), Value(), Value()};
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        acc[0] += wrapped[i];
+        acc[1] += wrapped[i + 1];
+        acc[2] += wrapped[i + 2];
+        acc[3] += wrapped[i + 3];
+    }
+    for (; i < size; ++i) {
+        acc[0] += wrapped[i];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+// Скалярное произведение, вычисляется одним проходом без временного вектора
+template <typename Lhs, typename Rhs, typename = std::enable_if_t<detail::kIsVectorLike<Lhs> && detail::kIsVectorLike<Rhs>>>
+auto Dot(const Lhs& lhs, const Rhs& rhs) {
+    return Sum(lhs * rhs);
+}
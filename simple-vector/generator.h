@@ -0,0 +1,161 @@
+#pragma once
+#include "simple_vector.h"
+#include <exception>
+#include <utility>
+
+#if !defined(__cpp_impl_coroutine) || __cpp_impl_coroutine < 201902L
+#error "generator.h requires C++20 coroutines"
+#endif
+
+#include <coroutine>
+
+// Ленивая последовательность значений, порождаемая сопрограммой через co_yield.
+// Сопрограмма может сообщить, сколько ещё значений ожидается,
+// выполнив co_yield Reserve(count): получатель, например Collect,
+// заранее зарезервирует память одним выделением вместо нескольких удвоений
+template <typename Type>
+class Generator {
+public:
+    struct promise_type {
+        Generator get_return_object() noexcept {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always yield_value(Type value) noexcept(std::is_nothrow_move_assignable_v<Type>) {
+            current_ = std::move(value);
+            return {};
+        }
+
+        // Подсказка о размере не прерывает сопрограмму
+        std::suspend_never yield_value(ReserveProxyObj hint) noexcept {
+            reserve_hint_ += hint.capacity_to_reserve_;
+            return {};
+        }
+
+        void return_void() noexcept {
+        }
+
+        void unhandled_exception() noexcept {
+            exception_ = std::current_exception();
+        }
+
+        Type current_{};
+        size_t reserve_hint_ = 0;
+        std::exception_ptr exception_;
+    };
+
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    Generator(Generator&& other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr)) {
+    }
+
+    Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+            std::swap(handle_, other.handle_);
+        }
+        return *this;
+    }
+
+    ~Generator() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    // Продвигает сопрограмму до следующего значения.
+    // Возвращает false, когда значения закончились.
+    // Исключение, выброшенное в сопрограмме, выбрасывается отсюда
+    bool Next() {
+        if (!handle_ || handle_.done()) {
+            return false;
+        }
+        handle_.resume();
+        if (handle_.promise().exception_) {
+            std::rethrow_exception(std::exchange(handle_.promise().exception_, nullptr));
+        }
+        return !handle_.done();
+    }
+
+    // Текущее значение, действительно после Next(), вернувшего true
+    Type& Value() noexcept {
+        return handle_.promise().current_;
+    }
+
+    // Возвращает накопленную подсказку о количестве значений и обнуляет её
+    size_t TakeReserveHint() noexcept {
+        return handle_ ? std::exchange(handle_.promise().reserve_hint_, 0) : 0;
+    }
+
+    // Итератор для range-based for
+    class Iterator {
+    public:
+        explicit Iterator(Generator* generator) noexcept
+            : generator_(generator) {
+        }
+
+        Type& operator*() const noexcept {
+            return generator_->Value();
+        }
+
+        Iterator& operator++() {
+            if (!generator_->Next()) {
+                generator_ = nullptr;
+            }
+            return *this;
+        }
+
+        bool operator==(std::default_sentinel_t) const noexcept {
+            return generator_ == nullptr;
+        }
+
+    private:
+        Generator* generator_;
+    };
+
+    Iterator begin() {
+        return Iterator(Next() ? this : nullptr);
+    }
+
+    std::default_sentinel_t end() const noexcept {
+        return {};
+    }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) noexcept
+        : handle_(handle) {
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Добавляет все оставшиеся значения генератора в конец out.
+// Подсказки co_yield Reserve(count) превращаются в out.Reserve,
+// так что память выделяется сразу под весь ожидаемый объём
+template <typename Type>
+void AppendTo(Generator<Type>& generator, SimpleVector<Type>& out) {
+    while (generator.Next()) {
+        if (const size_t hint = generator.TakeReserveHint(); hint != 0) {
+            out.Reserve(out.GetSize() + hint);
+        }
+        out.PushBack(std::move(generator.Value()));
+    }
+}
+
+// Собирает значения генератора в новый вектор.
+// size_hint позволяет зарезервировать память, если размер известен вызывающему
+template <typename Type>
+SimpleVector<Type> Collect(Generator<Type> generator, size_t size_hint = 0) {
+    SimpleVector<Type> result(Reserve(size_hint));
+    AppendTo(generator, result);
+    return result;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+template <typename Type>
+class SimpleVector;
+
+namespace detail {
+
+inline constexpr uint64_t kHashPrime1 = 0x9E3779B185EBCA87ULL;
+inline constexpr uint64_t kHashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+inline constexpr uint64_t kHashPrime3 = 0x165667B19E3779F9ULL;
+inline constexpr uint64_t kHashPrime4 = 0x85EBCA77C2B2AE63ULL;
+
+inline constexpr uint64_t RotateLeft(uint64_t value, int bits) noexcept {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t LoadWord(const unsigned char* bytes) noexcept {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+}
+
+inline constexpr uint64_t HashRound(uint64_t acc, uint64_t word) noexcept {
+    return RotateLeft(acc + word * kHashPrime2, 31) * kHashPrime1;
+}
+
+// Перемешивает биты так, что каждый бит результата зависит от всех битов value
+inline constexpr uint64_t Avalanche(uint64_t value) noexcept {
+    value ^= value >> 33;
+    value *= kHashPrime2;
+    value ^= value >> 29;
+    value *= kHashPrime3;
+    value ^= value >> 32;
+    return value;
+}
+
+}  // namespace detail
+
+// 64-битный хеш size байт по адресу data в духе xxHash64.
+// Основной цикл ведёт четыре независимые полосы по 8 байт,
+// поэтому за итерацию обрабатывается 32 байта без зависимостей между полосами.
+// Результат зависит от порядка байт платформы
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0) noexcept {
+    using namespace detail;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    size_t offset = 0;
+    uint64_t hash;
+    if (size >= 32) {
+        uint64_t lanes[4] = {seed + kHashPrime1 + kHashPrime2, seed + kHashPrime2, seed, seed - kHashPrime1};
+        for (; offset + 32 <= size; offset += 32) {
+            for (size_t lane = 0; lane < 4; ++lane) {
+                lanes[lane] = HashRound(lanes[lane], LoadWord(bytes + offset + lane * 8));
+            }
+        }
+        hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+        for (uint64_t lane : lanes) {
+            hash = (hash ^ HashRound(0, lane)) * kHashPrime1 + kHashPrime4;
+        }
+    } else {
+        hash = seed + kHashPrime3;
+    }
+    hash += size;
+    for (; offset + 8 <= size; offset += 8) {
+        hash = RotateLeft(hash ^ HashRound(0, LoadWord(bytes + offset)), 27) * kHashPrime1 + kHashPrime4;
+    }
+    if (offset < size) {
+        uint64_t tail = 0;
+        std::memcpy(&tail, bytes + offset, size - offset);
+        hash = RotateLeft(hash ^ (tail * kHashPrime1), 23) * kHashPrime2 + kHashPrime3;
+    }
+    return Avalanche(hash);
+}
+
+// Хеш последовательности из size элементов.
+// Если у типа нет байтов-заполнителей и равные значения совпадают побайтно,
+// память хешируется целиком, иначе комбинируются std::hash отдельных элементов
+// (так, например, 0.0 и -0.0 дают одинаковый хеш)
+template <typename Type>
+uint64_t HashElements(const Type* items, size_t size) noexcept {
+    if constexpr (std::has_unique_object_representations_v<Type>) {
+        return HashBytes(items, size * sizeof(Type));
+    } else {
+        uint64_t hash = detail::kHashPrime3 + size;
+        for (size_t i = 0; i < size; ++i) {
+            hash = detail::RotateLeft(hash ^ detail::HashRound(0, std::hash<Type>{}(items[i])), 27) * detail::kHashPrime1;
+        }
+        return detail::Avalanche(hash);
+    }
+}
+
+// Неизменяемый ключ для хеш-таблиц: вектор вместе с заранее посчитанным хешем.
+// Сравнение сначала проверяет хеши и размеры и лишь при их совпадении - элементы
+template <typename Type>
+class HashedVector {
+public:
+    explicit HashedVector(SimpleVector<Type> vector)
+        : vector_(std::move(vector))
+        , hash_(vector_.Hash()) {
+    }
+
+    const SimpleVector<Type>& Get() const noexcept {
+        return vector_;
+    }
+
+    uint64_t Hash() const noexcept {
+        return hash_;
+    }
+
+private:
+    SimpleVector<Type> vector_;
+    uint64_t hash_;
+};
+
+template <typename Type>
+inline bool operator==(const HashedVector<Type>& lhs, const HashedVector<Type>& rhs) {
+    return lhs.Hash() == rhs.Hash() && lhs.Get() == rhs.Get();
+}
+
+template <typename Type>
+inline bool operator!=(const HashedVector<Type>& lhs, const HashedVector<Type>& rhs) {
+    return !(lhs == rhs);
+}
+
+namespace std {
+
+template <typename Type>
+struct hash<SimpleVector<Type>> {
+    size_t operator()(const SimpleVector<Type>& vector) const noexcept {
+        return static_cast<size_t>(vector.Hash());
+    }
+};
+
+template <typename Type>
+struct hash<HashedVector<Type>> {
+    size_t operator()(const HashedVector<Type>& key) const noexcept {
+        return static_cast<size_t>(key.Hash());
+    }
+};
+
+}  // namespace std
@@ -19,5 +19,18 @@ int main() {
     TestNoncopiableInsert();
     TestNoncopiableErase();
     TestNoncoiableResize();
+    TestSortAndSearch();
+    TestExpressions();
+    TestSpan();
+    TestHardenedMode();
+    TestConstexprTables();
+    TestStaticVector();
+    TestBatchErase();
+    TestPrefetchTraversal();
+    TestMemoryAccounting();
+    TestHash();
+    TestGenerator();
+    TestBatchPipeline();
+    TestMatrix();
     return 0;
 }
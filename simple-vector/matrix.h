@@ -0,0 +1,476 @@
+#pragma once
+#include "array_ptr.h"
+#include "simple_vector.h"
+#include "span.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Выравнивание строк матрицы с дополнением, в байтах: размер строки кэша,
+// его же достаточно для самых широких векторных загрузок
+inline constexpr size_t kMatrixAlignment = 64;
+
+// Сторона квадратного блока при блочном обходе, в элементах.
+// Блок 32x32 из float занимает 4 КиБ, так что исходный и целевой блоки
+// вместе помещаются в L1 при любом порядке хранения
+inline constexpr size_t kMatrixTileSize = 32;
+
+enum class MatrixLayout {
+    RowMajor,
+    ColumnMajor,
+};
+
+// Невладеющее двумерное представление: элемент (row, col) находится
+// по адресу data + row * row_stride + col * col_stride.
+// Один и тот же класс описывает матрицы, хранящиеся по строкам, по столбцам,
+// с дополненными строками, их подматрицы и транспонированные представления
+template <typename Type>
+class MatrixView {
+public:
+    MatrixView() noexcept = default;
+
+    constexpr MatrixView(Type* data, size_t rows, size_t cols, size_t row_stride, size_t col_stride) noexcept
+        : data_(data)
+        , rows_(rows)
+        , cols_(cols)
+        , row_stride_(row_stride)
+        , col_stride_(col_stride) {
+    }
+
+    // Позволяет передавать MatrixView<T> туда, где ожидается MatrixView<const T>
+    template <typename Other, typename = std::enable_if_t<std::is_convertible_v<Other (*)[], Type (*)[]>>>
+    constexpr MatrixView(MatrixView<Other> other) noexcept
+        : data_(other.GetData())
+        , rows_(other.GetRows())
+        , cols_(other.GetCols())
+        , row_stride_(other.GetRowStride())
+        , col_stride_(other.GetColStride()) {
+    }
+
+    constexpr Type* GetData() const noexcept {
+        return data_;
+    }
+
+    constexpr size_t GetRows() const noexcept {
+        return rows_;
+    }
+
+    constexpr size_t GetCols() const noexcept {
+        return cols_;
+    }
+
+    constexpr size_t GetRowStride() const noexcept {
+        return row_stride_;
+    }
+
+    constexpr size_t GetColStride() const noexcept {
+        return col_stride_;
+    }
+
+    constexpr bool IsEmpty() const noexcept {
+        return rows_ == 0 || cols_ == 0;
+    }
+
+    // Сообщает, лежат ли соседние элементы строки в памяти подряд,
+    // то есть выгоднее ли обходить представление по строкам
+    constexpr bool IsRowMajor() const noexcept {
+        return col_stride_ <= row_stride_;
+    }
+
+    constexpr Type& operator()(size_t row, size_t col) const noexcept {
+        assert(row < rows_ && col < cols_);
+        return data_[row * row_stride_ + col * col_stride_];
+    }
+
+    constexpr StridedSpan<Type> Row(size_t row) const noexcept {
+        assert(row < rows_);
+        return StridedSpan<Type>(data_ + row * row_stride_, cols_, col_stride_);
+    }
+
+    constexpr StridedSpan<Type> Col(size_t col) const noexcept {
+        assert(col < cols_);
+        return StridedSpan<Type>(data_ + col * col_stride_, rows_, row_stride_);
+    }
+
+    // Подматрица из rows строк и cols столбцов с левым верхним углом в (row, col)
+    constexpr MatrixView Block(size_t row, size_t col, size_t rows, size_t cols) const noexcept {
+        assert(row <= rows_ && rows <= rows_ - row);
+        assert(col <= cols_ && cols <= cols_ - col);
+        return MatrixView(data_ + row * row_stride_ + col * col_stride_, rows, cols, row_stride_, col_stride_);
+    }
+
+    // Транспонированное представление тех же данных, без копирования
+    constexpr MatrixView Transposed() const noexcept {
+        return MatrixView(data_, cols_, rows_, col_stride_, row_stride_);
+    }
+
+private:
+    Type* data_ = nullptr;
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    size_t row_stride_ = 0;
+    size_t col_stride_ = 0;
+};
+
+template <typename Type>
+using ConstMatrixView = MatrixView<const Type>;
+
+namespace detail {
+
+template <typename Type>
+void FreeAligned(Type* items, void*) noexcept {
+    ::operator delete(items, std::align_val_t{kMatrixAlignment});
+}
+
+// Буфер из count элементов, инициализированных значением по умолчанию.
+// Для тривиально разрушаемых типов начало буфера выровнено на kMatrixAlignment:
+// deleter ArrayPtr не знает количества элементов и не может вызвать деструкторы,
+// поэтому остальные типы размещаются обычным new[] с выравниванием самого типа
+template <typename Type>
+ArrayPtr<Type> AllocateMatrixStorage(size_t count) {
+    if (count == 0)
+    {
+        return ArrayPtr<Type>();
+    }
+    if constexpr (std::is_trivially_destructible_v<Type> && alignof(Type) <= kMatrixAlignment) {
+        Type* items = static_cast<Type*>(::operator new(count * sizeof(Type), std::align_val_t{kMatrixAlignment}));
+        try {
+            std::uninitialized_value_construct_n(items, count);
+        } catch (...) {
+            FreeAligned(items, nullptr);
+            throw;
+        }
+        return ArrayPtr<Type>(items, &FreeAligned<Type>);
+    } else {
+        ArrayPtr<Type> items(count);
+        // new[] оставляет такие элементы неинициализированными
+        if constexpr (std::is_trivially_default_constructible_v<Type>) {
+            std::fill_n(items.Get(), count, Type());
+        }
+        return items;
+    }
+}
+
+}  // namespace detail
+
+// Плотная матрица поверх SimpleVector.
+// Порядок хранения задаётся layout. При padded = true расстояние между началами
+// соседних строк (столбцов для ColumnMajor) округляется вверх до kMatrixAlignment байт,
+// и каждая строка начинается с выровненного адреса, что удобно для векторных инструкций.
+// Элементы дополнения инициализированы значением по умолчанию и в представления не входят
+template <typename Type>
+class Matrix {
+public:
+    Matrix() noexcept = default;
+
+    Matrix(size_t rows, size_t cols, MatrixLayout layout = MatrixLayout::RowMajor, bool padded = false)
+        : rows_(rows)
+        , cols_(cols)
+        , layout_(layout)
+        , padded_(padded)
+        , leading_dimension_(ComputeLeadingDimension(layout == MatrixLayout::RowMajor ? cols : rows, padded)) {
+        const size_t lines = layout == MatrixLayout::RowMajor ? rows : cols;
+        if (leading_dimension_ != 0 && lines > static_cast<size_t>(-1) / sizeof(Type) / leading_dimension_)
+        {
+            throw std::length_error("matrix is too large");
+        }
+        const size_t count = lines * leading_dimension_;
+        // Присваивание SimpleVector копирует элементы в новый буфер и теряет выравнивание,
+        // поэтому выделенный буфер передаётся обменом
+        SimpleVector<Type> storage(detail::AllocateMatrixStorage<Type>(count), count);
+        storage_.swap(storage);
+    }
+
+    Matrix(size_t rows, size_t cols, const Type& value, MatrixLayout layout = MatrixLayout::RowMajor,
+           bool padded = false)
+        : Matrix(rows, cols, layout, padded) {
+        Fill(value);
+    }
+
+    // Копия сохраняет порядок хранения и выравнивание строк
+    Matrix(const Matrix& other)
+        : Matrix(other.rows_, other.cols_, other.layout_, other.padded_) {
+        std::copy(other.storage_.begin(), other.storage_.end(), storage_.begin());
+    }
+
+    Matrix(Matrix&& other) noexcept
+        : storage_(std::move(other.storage_))
+        , rows_(std::exchange(other.rows_, 0))
+        , cols_(std::exchange(other.cols_, 0))
+        , layout_(other.layout_)
+        , padded_(other.padded_)
+        , leading_dimension_(std::exchange(other.leading_dimension_, 0)) {
+    }
+
+    Matrix& operator=(const Matrix& rhs) {
+        if (this != &rhs)
+        {
+            Matrix copy(rhs);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    Matrix& operator=(Matrix&& rhs) noexcept {
+        if (this != &rhs)
+        {
+            Matrix moved(std::move(rhs));
+            swap(moved);
+        }
+        return *this;
+    }
+
+    size_t GetRows() const noexcept {
+        return rows_;
+    }
+
+    size_t GetCols() const noexcept {
+        return cols_;
+    }
+
+    MatrixLayout GetLayout() const noexcept {
+        return layout_;
+    }
+
+    bool IsPadded() const noexcept {
+        return padded_;
+    }
+
+    // Расстояние в элементах между началами соседних строк (столбцов для ColumnMajor)
+    size_t GetLeadingDimension() const noexcept {
+        return leading_dimension_;
+    }
+
+    Type& operator()(size_t row, size_t col) noexcept {
+        return View()(row, col);
+    }
+
+    const Type& operator()(size_t row, size_t col) const noexcept {
+        return View()(row, col);
+    }
+
+    MatrixView<Type> View() noexcept {
+        return MakeView(storage_.AsSpan().GetData());
+    }
+
+    ConstMatrixView<Type> View() const noexcept {
+        return MakeView(storage_.AsSpan().GetData());
+    }
+
+    operator MatrixView<Type>() noexcept {
+        return View();
+    }
+
+    operator ConstMatrixView<Type>() const noexcept {
+        return View();
+    }
+
+    StridedSpan<Type> Row(size_t row) noexcept {
+        return View().Row(row);
+    }
+
+    StridedSpan<const Type> Row(size_t row) const noexcept {
+        return View().Row(row);
+    }
+
+    StridedSpan<Type> Col(size_t col) noexcept {
+        return View().Col(col);
+    }
+
+    StridedSpan<const Type> Col(size_t col) const noexcept {
+        return View().Col(col);
+    }
+
+    // Хранилище целиком, вместе с элементами дополнения
+    const SimpleVector<Type>& GetStorage() const noexcept {
+        return storage_;
+    }
+
+    // Присваивает value всем элементам, включая дополнение
+    void Fill(const Type& value) {
+        std::fill(storage_.begin(), storage_.end(), value);
+    }
+
+    void swap(Matrix& other) noexcept {
+        storage_.swap(other.storage_);
+        std::swap(rows_, other.rows_);
+        std::swap(cols_, other.cols_);
+        std::swap(layout_, other.layout_);
+        std::swap(padded_, other.padded_);
+        std::swap(leading_dimension_, other.leading_dimension_);
+    }
+
+private:
+    static size_t ComputeLeadingDimension(size_t line_size, bool padded) noexcept {
+        if (!padded || kMatrixAlignment % sizeof(Type) != 0)
+        {
+            return line_size;
+        }
+        const size_t step = kMatrixAlignment / sizeof(Type);
+        return (line_size + step - 1) / step * step;
+    }
+
+    template <typename Value>
+    MatrixView<Value> MakeView(Value* data) const noexcept {
+        if (layout_ == MatrixLayout::RowMajor)
+        {
+            return MatrixView<Value>(data, rows_, cols_, leading_dimension_, 1);
+        }
+        return MatrixView<Value>(data, rows_, cols_, 1, leading_dimension_);
+    }
+
+    SimpleVector<Type> storage_;
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    MatrixLayout layout_ = MatrixLayout::RowMajor;
+    bool padded_ = false;
+    size_t leading_dimension_ = 0;
+};
+
+template <typename Type>
+inline bool operator==(const Matrix<Type>& lhs, const Matrix<Type>& rhs) {
+    if (lhs.GetRows() != rhs.GetRows() || lhs.GetCols() != rhs.GetCols())
+    {
+        return false;
+    }
+    for (size_t row = 0; row < lhs.GetRows(); ++row) {
+        if (!std::equal(lhs.Row(row).begin(), lhs.Row(row).end(), rhs.Row(row).begin()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Type>
+inline bool operator!=(const Matrix<Type>& lhs, const Matrix<Type>& rhs) {
+    return !(lhs == rhs);
+}
+
+// Вызывает func(tile, row, col) для каждого блока не больше tile_rows x tile_cols,
+// где (row, col) - левый верхний угол блока. Блоки перебираются в порядке хранения:
+// для представления по строкам - слева направо, затем сверху вниз, иначе - по столбцам
+template <typename Type, typename Func>
+void ForEachTile(MatrixView<Type> view, size_t tile_rows, size_t tile_cols, Func func) {
+    assert(tile_rows > 0 && tile_cols > 0);
+    const size_t rows = view.GetRows();
+    const size_t cols = view.GetCols();
+    if (view.IsRowMajor())
+    {
+        for (size_t row = 0; row < rows; row += tile_rows) {
+            for (size_t col = 0; col < cols; col += tile_cols) {
+                func(view.Block(row, col, std::min(tile_rows, rows - row), std::min(tile_cols, cols - col)), row, col);
+            }
+        }
+    }
+    else
+    {
+        for (size_t col = 0; col < cols; col += tile_cols) {
+            for (size_t row = 0; row < rows; row += tile_rows) {
+                func(view.Block(row, col, std::min(tile_rows, rows - row), std::min(tile_cols, cols - col)), row, col);
+            }
+        }
+    }
+}
+
+// Записывает в destination транспонированную source.
+// Наивное копирование читает одну из матриц с шагом в целую строку, и каждое
+// обращение промахивается мимо кэша. Здесь копируются блоки kMatrixTileSize x kMatrixTileSize:
+// строки обоих блоков остаются в кэше, пока блок не будет скопирован целиком
+template <typename Source, typename Type>
+void Transpose(MatrixView<Source> source, MatrixView<Type> destination) {
+    static_assert(std::is_same_v<std::remove_cv_t<Source>, Type>, "matrix element types do not match");
+    if (source.GetRows() != destination.GetCols() || source.GetCols() != destination.GetRows())
+    {
+        throw std::invalid_argument("matrix dimensions do not match");
+    }
+    ForEachTile(source, kMatrixTileSize, kMatrixTileSize, [&destination](MatrixView<Source> tile, size_t row, size_t col) {
+        const MatrixView<Type> target = destination.Block(col, row, tile.GetCols(), tile.GetRows());
+        // Внутренний цикл идёт вдоль непрерывной размерности приёмника
+        if (target.IsRowMajor())
+        {
+            for (size_t i = 0; i < tile.GetCols(); ++i) {
+                for (size_t j = 0; j < tile.GetRows(); ++j) {
+                    target(i, j) = tile(j, i);
+                }
+            }
+        }
+        else
+        {
+            for (size_t j = 0; j < tile.GetRows(); ++j) {
+                for (size_t i = 0; i < tile.GetCols(); ++i) {
+                    target(i, j) = tile(j, i);
+                }
+            }
+        }
+    });
+}
+
+// Возвращает транспонированную матрицу с тем же порядком хранения и дополнением
+template <typename Type>
+Matrix<Type> Transpose(const Matrix<Type>& matrix) {
+    Matrix<Type> result(matrix.GetCols(), matrix.GetRows(), matrix.GetLayout(), matrix.IsPadded());
+    Transpose(matrix.View(), result.View());
+    return result;
+}
+
+// Сворачивает каждый столбец: result[col] = op(...op(op(init, view(0, col)), view(1, col))..., view(rows - 1, col)).
+// Для представления по строкам матрица проходится строка за строкой, а все аккумуляторы
+// обновляются одновременно, так что память читается подряд и цикл векторизуется
+template <typename Type, typename Result, typename BinaryOp>
+SimpleVector<Result> ReduceCols(MatrixView<Type> view, Result init, BinaryOp op) {
+    SimpleVector<Result> result(view.GetCols(), init);
+    Result* accumulators = result.AsSpan().GetData();
+    if (view.IsRowMajor())
+    {
+        for (size_t row = 0; row < view.GetRows(); ++row) {
+            const StridedSpan<Type> items = view.Row(row);
+            for (size_t col = 0; col < items.GetSize(); ++col) {
+                accumulators[col] = op(accumulators[col], items[col]);
+            }
+        }
+    }
+    else
+    {
+        for (size_t col = 0; col < view.GetCols(); ++col) {
+            Result accumulator = init;
+            for (auto& item : view.Col(col)) {
+                accumulator = op(accumulator, item);
+            }
+            accumulators[col] = accumulator;
+        }
+    }
+    return result;
+}
+
+// Сворачивает каждую строку, см. ReduceCols
+template <typename Type, typename Result, typename BinaryOp>
+SimpleVector<Result> ReduceRows(MatrixView<Type> view, Result init, BinaryOp op) {
+    return ReduceCols(view.Transposed(), std::move(init), std::move(op));
+}
+
+template <typename Type>
+SimpleVector<std::remove_cv_t<Type>> ColSums(MatrixView<Type> view) {
+    return ReduceCols(view, std::remove_cv_t<Type>(), std::plus<>());
+}
+
+template <typename Type>
+SimpleVector<std::remove_cv_t<Type>> RowSums(MatrixView<Type> view) {
+    return ReduceRows(view, std::remove_cv_t<Type>(), std::plus<>());
+}
+
+template <typename Type>
+SimpleVector<Type> ColSums(const Matrix<Type>& matrix) {
+    return ColSums(matrix.View());
+}
+
+template <typename Type>
+SimpleVector<Type> RowSums(const Matrix<Type>& matrix) {
+    return RowSums(matrix.View());
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+
+// Учёт памяти всех живых SimpleVector, владеющих памятью.
+// Включается флагом -DSIMPLE_VECTOR_MEMORY_STATS=1: тогда вектор регистрируется
+// в глобальном реестре, получив буфер, и удаляется из него, освободив буфер или разрушившись.
+// Векторы без памяти, например элементы неиспользуемой части буфера вектора векторов,
+// в реестр не попадают и в статистике не видны.
+// Мьютекс реестра защищает только список узлов: создавать и разрушать векторы
+// можно из любых потоков. Размер и вместимость векторов читаются без синхронизации,
+// поэтому GetVectorMemoryStats, как и TrimAll, можно вызывать, только когда другие
+// потоки не изменяют зарегистрированные векторы, иначе это гонка данных
+
+// Снимок использования памяти векторами
+struct VectorMemoryStats {
+    static constexpr size_t kHistogramBuckets = 10;
+
+    // Количество векторов с выделенной памятью
+    size_t live_vectors = 0;
+    // Память, занятая элементами: size * sizeof(Type)
+    size_t used_bytes = 0;
+    // Выделенная память: capacity * sizeof(Type)
+    size_t reserved_bytes = 0;
+    // fill_ratio_histogram[i] - количество векторов с долей заполнения size / capacity
+    // в [i * 10%, (i + 1) * 10%), полностью заполненные попадают в последнюю корзину
+    size_t fill_ratio_histogram[kHistogramBuckets] = {};
+};
+
+// Узел реестра, встраиваемый в каждый вектор
+class VectorMemoryNode {
+public:
+    // Сообщает занятую и выделенную память вектора owner
+    using StatsFunc = void (*)(const void* owner, size_t& used_bytes, size_t& reserved_bytes);
+    // Освобождает неиспользуемую память вектора owner, возвращает количество освобождённых байт
+    using TrimFunc = size_t (*)(void* owner);
+
+    // Созданный узел ещё не зарегистрирован, см. Track
+    VectorMemoryNode(void* owner, StatsFunc stats, TrimFunc trim) noexcept;
+    VectorMemoryNode(const VectorMemoryNode&) = delete;
+    VectorMemoryNode& operator=(const VectorMemoryNode&) = delete;
+    ~VectorMemoryNode();
+
+    // Добавляет узел в реестр или убирает из него.
+    // Вызывается только потоком, изменяющим вектор-владелец
+    void Track(bool tracked) noexcept;
+
+private:
+    friend class VectorMemoryRegistry;
+
+    bool tracked_ = false;
+    VectorMemoryNode* prev_ = nullptr;
+    VectorMemoryNode* next_ = nullptr;
+    void* owner_;
+    StatsFunc stats_;
+    TrimFunc trim_;
+};
+
+class VectorMemoryRegistry {
+public:
+    static VectorMemoryRegistry& Instance() {
+        static VectorMemoryRegistry registry;
+        return registry;
+    }
+
+    void Register(VectorMemoryNode* node) noexcept {
+        std::lock_guard lock(mutex_);
+        node->next_ = head_;
+        if (head_)
+        {
+            head_->prev_ = node;
+        }
+        head_ = node;
+    }
+
+    void Unregister(VectorMemoryNode* node) noexcept {
+        std::lock_guard lock(mutex_);
+        // Узел может исчезнуть во время обхода в TrimAll, например при сжатии вектора векторов
+        if (cursor_ == node)
+        {
+            cursor_ = node->next_;
+        }
+        if (node->prev_)
+        {
+            node->prev_->next_ = node->next_;
+        }
+        else
+        {
+            head_ = node->next_;
+        }
+        if (node->next_)
+        {
+            node->next_->prev_ = node->prev_;
+        }
+        node->prev_ = nullptr;
+        node->next_ = nullptr;
+    }
+
+    // Читает поля векторов без синхронизации, см. комментарий в начале файла
+    VectorMemoryStats GetStats() const {
+        std::lock_guard lock(mutex_);
+        VectorMemoryStats stats;
+        for (const VectorMemoryNode* node = head_; node; node = node->next_)
+        {
+            size_t used = 0;
+            size_t reserved = 0;
+            node->stats_(node->owner_, used, reserved);
+            stats.live_vectors++;
+            stats.used_bytes += used;
+            stats.reserved_bytes += reserved;
+            if (reserved != 0)
+            {
+                const size_t bucket = used * VectorMemoryStats::kHistogramBuckets / reserved;
+                stats.fill_ratio_histogram[bucket < VectorMemoryStats::kHistogramBuckets ? bucket : VectorMemoryStats::kHistogramBuckets - 1]++;
+            }
+        }
+        return stats;
+    }
+
+    // Освобождает неиспользуемую память всех векторов, возвращает количество освобождённых байт
+    size_t TrimAll() {
+        std::lock_guard lock(mutex_);
+        size_t released = 0;
+        cursor_ = head_;
+        while (cursor_)
+        {
+            VectorMemoryNode* node = cursor_;
+            cursor_ = node->next_;
+            released += node->trim_(node->owner_);
+        }
+        return released;
+    }
+
+private:
+    VectorMemoryRegistry() = default;
+
+    // Рекурсивный, так как сжатие вектора векторов создаёт и разрушает вложенные векторы
+    mutable std::recursive_mutex mutex_;
+    VectorMemoryNode* head_ = nullptr;
+    // Следующий узел, который посетит TrimAll
+    VectorMemoryNode* cursor_ = nullptr;
+};
+
+inline VectorMemoryNode::VectorMemoryNode(void* owner, StatsFunc stats, TrimFunc trim) noexcept
+    : owner_(owner)
+    , stats_(stats)
+    , trim_(trim) {
+}
+
+inline VectorMemoryNode::~VectorMemoryNode() {
+    Track(false);
+}
+
+inline void VectorMemoryNode::Track(bool tracked) noexcept {
+    if (tracked == tracked_)
+    {
+        return;
+    }
+    if (tracked)
+    {
+        VectorMemoryRegistry::Instance().Register(this);
+    }
+    else
+    {
+        VectorMemoryRegistry::Instance().Unregister(this);
+    }
+    tracked_ = tracked;
+}
+
+// Требует, чтобы зарегистрированные векторы не изменялись в других потоках во время вызова
+inline VectorMemoryStats GetVectorMemoryStats() {
+    return VectorMemoryRegistry::Instance().GetStats();
+}
+
+// Точка для обработчика нехватки памяти: сжимает все векторы до их размера.
+// Как и GetVectorMemoryStats, требует, чтобы векторы не изменялись в других потоках
+inline size_t TrimAll() {
+    return VectorMemoryRegistry::Instance().TrimAll();
+}
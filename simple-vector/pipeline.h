@@ -0,0 +1,209 @@
+#pragma once
+#include "array_ptr.h"
+#include "simple_vector.h"
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace detail {
+
+// Кольцевая очередь номеров пакетов фиксированной вместимости.
+// Не синхронизирована: доступ защищает мьютекс конвейера
+class BatchQueue {
+public:
+    explicit BatchQueue(size_t capacity)
+        : slots_(capacity)
+        , capacity_(capacity) {
+    }
+
+    bool IsEmpty() const noexcept {
+        return count_ == 0;
+    }
+
+    void Push(size_t batch) noexcept {
+        slots_[(head_ + count_) % capacity_] = batch;
+        count_++;
+    }
+
+    size_t Pop() noexcept {
+        const size_t batch = slots_[head_];
+        head_ = (head_ + 1) % capacity_;
+        count_--;
+        return batch;
+    }
+
+    void Clear() noexcept {
+        head_ = 0;
+        count_ = 0;
+    }
+
+private:
+    ArrayPtr<size_t> slots_;
+    size_t capacity_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+};
+
+}  // namespace detail
+
+// Двухстадийный конвейер производитель/потребитель с ограниченной очередью.
+// Производитель в отдельном потоке заполняет пакеты - векторы с заранее
+// выделенной памятью, потребитель в вызывающем потоке обрабатывает их.
+// Обработанный пакет очищается с сохранением вместимости и возвращается производителю,
+// поэтому в установившемся режиме память не выделяется вовсе,
+// а число пакетов ограничивает, насколько производитель может обогнать потребителя
+template <typename Type>
+class BatchPipeline {
+public:
+    // batch_count пакетов вместимостью batch_capacity элементов каждый
+    BatchPipeline(size_t batch_count, size_t batch_capacity)
+        : batches_(batch_count)
+        , free_(batch_count)
+        , ready_(batch_count)
+        , batch_capacity_(batch_capacity) {
+        if (batch_count == 0)
+        {
+            throw std::invalid_argument("batch count must be positive");
+        }
+        for (size_t i = 0; i < batch_count; ++i) {
+            batches_[i].Reserve(batch_capacity);
+        }
+    }
+
+    BatchPipeline(const BatchPipeline&) = delete;
+    BatchPipeline& operator=(const BatchPipeline&) = delete;
+
+    size_t GetBatchCount() const noexcept {
+        return batches_.GetSize();
+    }
+
+    size_t GetBatchCapacity() const noexcept {
+        return batch_capacity_;
+    }
+
+    // Запускает конвейер и возвращается, когда все пакеты обработаны.
+    // produce(SimpleVector<Type>& batch) получает пустой пакет, дописывает в него данные
+    // и возвращает false, когда данные закончились (последний пакет при этом тоже обрабатывается).
+    // Производителю стоит не превышать GetBatchCapacity(), иначе пакет перераспределит память.
+    // consume(SimpleVector<Type>& batch) вызывается для каждого непустого пакета по порядку.
+    // Исключение любой из стадий останавливает обе и выбрасывается из Run
+    template <typename Producer, typename Consumer>
+    void Run(Producer produce, Consumer consume) {
+        // Очереди могли остаться непустыми, если прошлый запуск прервался исключением,
+        // в том числе до старта потока производителя
+        free_.Clear();
+        ready_.Clear();
+        for (size_t i = 0; i < batches_.GetSize(); ++i) {
+            batches_[i].Clear();
+            free_.Push(i);
+        }
+        finished_ = false;
+        stopped_ = false;
+        producer_error_ = nullptr;
+
+        std::thread producer([this, &produce] {
+            ProduceLoop(produce);
+        });
+        std::exception_ptr consumer_error;
+        try {
+            ConsumeLoop(consume);
+        } catch (...) {
+            consumer_error = std::current_exception();
+            Stop();
+        }
+        producer.join();
+        if (consumer_error)
+        {
+            std::rethrow_exception(consumer_error);
+        }
+        if (producer_error_)
+        {
+            std::rethrow_exception(producer_error_);
+        }
+    }
+
+private:
+    template <typename Producer>
+    void ProduceLoop(Producer& produce) {
+        try {
+            bool more = true;
+            while (more) {
+                size_t batch;
+                {
+                    std::unique_lock lock(mutex_);
+                    free_available_.wait(lock, [this] {
+                        return stopped_ || !free_.IsEmpty();
+                    });
+                    if (stopped_)
+                    {
+                        return;
+                    }
+                    batch = free_.Pop();
+                }
+                more = produce(batches_[batch]);
+                std::lock_guard lock(mutex_);
+                if (batches_[batch].IsEmpty())
+                {
+                    free_.Push(batch);
+                }
+                else
+                {
+                    ready_.Push(batch);
+                }
+                finished_ = !more;
+                ready_available_.notify_one();
+            }
+        } catch (...) {
+            std::lock_guard lock(mutex_);
+            producer_error_ = std::current_exception();
+            finished_ = true;
+            ready_available_.notify_one();
+        }
+    }
+
+    template <typename Consumer>
+    void ConsumeLoop(Consumer& consume) {
+        for (;;) {
+            size_t batch;
+            {
+                std::unique_lock lock(mutex_);
+                ready_available_.wait(lock, [this] {
+                    return finished_ || !ready_.IsEmpty();
+                });
+                if (ready_.IsEmpty())
+                {
+                    return;
+                }
+                batch = ready_.Pop();
+            }
+            consume(batches_[batch]);
+            // Clear сохраняет вместимость, так что пакет переиспользуется без выделения памяти
+            batches_[batch].Clear();
+            std::lock_guard lock(mutex_);
+            free_.Push(batch);
+            free_available_.notify_one();
+        }
+    }
+
+    void Stop() {
+        std::lock_guard lock(mutex_);
+        stopped_ = true;
+        free_available_.notify_one();
+    }
+
+    SimpleVector<SimpleVector<Type>> batches_;
+    detail::BatchQueue free_;
+    detail::BatchQueue ready_;
+    size_t batch_capacity_;
+
+    std::mutex mutex_;
+    std::condition_variable free_available_;
+    std::condition_variable ready_available_;
+    bool finished_ = false;
+    bool stopped_ = false;
+    std::exception_ptr producer_error_;
+};
@@ -0,0 +1,190 @@
+#pragma once
+#include "simple_vector.h"
+#include "span.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <xmmintrin.h>
+#endif
+
+// На сколько элементов вперёд запрашивать данные по умолчанию.
+// Должно хватать, чтобы перекрыть задержку обращения к памяти,
+// но не настолько много, чтобы вытеснять ещё не использованные строки кэша
+inline constexpr size_t kDefaultPrefetchDistance = 16;
+
+// Просит процессор заранее загрузить в кэш строку с адресом address.
+// Подсказка не влияет на корректность и не вызывает ошибок даже для невалидного адреса
+inline void PrefetchForRead(const void* address) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 0, 3);
+#elif defined(_MSC_VER)
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+namespace detail {
+
+// Вызывает visit(i) для каждого i из [0, count) по порядку.
+// Элемент data[index[i + distance]] запрашивается заранее, так что одновременно
+// в полёте находится около distance промахов кэша; первые distance элементов
+// запрашиваются до начала обхода
+template <typename Type, typename Visit>
+void VisitWithPrefetch(const Type* data, const size_t* index, size_t count, size_t distance, Visit visit) {
+    const size_t warmup = std::min(distance, count);
+    for (size_t i = 0; i < warmup; ++i) {
+        PrefetchForRead(data + index[i]);
+    }
+    size_t i = 0;
+    for (; i + distance < count; ++i) {
+        PrefetchForRead(data + index[i + distance]);
+        visit(i);
+    }
+    for (; i < count; ++i) {
+        visit(i);
+    }
+}
+
+}  // namespace detail
+
+// Копирует source[indices[i]] в out[i], заранее запрашивая элементы на distance шагов вперёд
+template <typename Type>
+void GatherInto(ConstSpan<Type> source, ConstSpan<size_t> indices, Span<Type> out,
+                size_t distance = kDefaultPrefetchDistance) {
+    assert(out.GetSize() == indices.GetSize());
+    const Type* data = source.GetData();
+    const size_t* index = indices.GetData();
+    detail::VisitWithPrefetch(data, index, indices.GetSize(), distance, [&](size_t i) {
+        assert(index[i] < source.GetSize());
+        out[i] = data[index[i]];
+    });
+}
+
+// То же, но размер out подгоняется под количество индексов
+template <typename Type>
+void GatherInto(const SimpleVector<Type>& source, ConstSpan<size_t> indices, SimpleVector<Type>& out,
+                size_t distance = kDefaultPrefetchDistance) {
+    out.Resize(indices.GetSize());
+    GatherInto(source.AsSpan(), indices, out.AsSpan(), distance);
+}
+
+// Вызывает func(index, source[index]) для каждого index из indices по порядку,
+// заранее запрашивая элементы на distance шагов вперёд
+template <typename Type, typename Func>
+void ForEachIndexed(const SimpleVector<Type>& source, ConstSpan<size_t> indices, Func func,
+                    size_t distance = kDefaultPrefetchDistance) {
+    const Type* data = source.AsSpan().GetData();
+    const size_t* index = indices.GetData();
+    detail::VisitWithPrefetch(data, index, indices.GetSize(), distance, [&](size_t i) {
+        assert(index[i] < source.GetSize());
+        func(index[i], data[index[i]]);
+    });
+}
+
+// Итератор по непрерывному массиву, который при каждом шаге
+// запрашивает элемент, находящийся на distance позиций впереди.
+// Полезен для тяжёлых элементов и обходов, которые аппаратный
+// предвыборщик не успевает распознать
+template <typename Type>
+class PrefetchingIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_cv_t<Type>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Type*;
+    using reference = Type&;
+
+    PrefetchingIterator() noexcept = default;
+
+    // end - конец массива: дальше него адрес для предвыборки не вычисляется
+    PrefetchingIterator(Type* ptr, Type* end, size_t distance) noexcept
+        : ptr_(ptr)
+        , end_(end)
+        , distance_(distance) {
+    }
+
+    Type& operator*() const noexcept {
+        return *ptr_;
+    }
+
+    Type* operator->() const noexcept {
+        return ptr_;
+    }
+
+    PrefetchingIterator& operator++() noexcept {
+        ++ptr_;
+        // Даже не разыменовывая, нельзя вычислять указатель дальше конца массива,
+        // поэтому у хвоста массива предвыборка не выполняется
+        if (static_cast<size_t>(end_ - ptr_) > distance_) {
+            PrefetchForRead(ptr_ + distance_);
+        }
+        return *this;
+    }
+
+    PrefetchingIterator operator++(int) noexcept {
+        PrefetchingIterator old = *this;
+        ++*this;
+        return old;
+    }
+
+    bool operator==(const PrefetchingIterator& other) const noexcept {
+        return ptr_ == other.ptr_;
+    }
+
+    bool operator!=(const PrefetchingIterator& other) const noexcept {
+        return ptr_ != other.ptr_;
+    }
+
+private:
+    Type* ptr_ = nullptr;
+    Type* end_ = nullptr;
+    size_t distance_ = kDefaultPrefetchDistance;
+};
+
+// Диапазон для range-based for с предвыборкой:
+// for (auto& item : WithPrefetch(vector)) { ... }
+// Обход идёт по сырым указателям из AsSpan, поэтому в усиленном режиме
+// итераторы не проверяются: вектор нельзя изменять, пока обход не закончен
+template <typename Type>
+class PrefetchingRange {
+public:
+    PrefetchingRange(Span<Type> items, size_t distance) noexcept
+        : items_(items)
+        , distance_(distance) {
+    }
+
+    // Первые distance + 1 элементов запрашиваются сразу: дальше каждый шаг
+    // итератора запрашивает элемент на distance позиций впереди
+    PrefetchingIterator<Type> begin() const noexcept {
+        const size_t size = items_.GetSize();
+        const size_t warmup = distance_ < size ? distance_ + 1 : size;
+        for (size_t i = 0; i < warmup; ++i) {
+            PrefetchForRead(items_.GetData() + i);
+        }
+        return PrefetchingIterator<Type>(items_.begin(), items_.end(), distance_);
+    }
+
+    PrefetchingIterator<Type> end() const noexcept {
+        return PrefetchingIterator<Type>(items_.end(), items_.end(), distance_);
+    }
+
+private:
+    Span<Type> items_;
+    size_t distance_;
+};
+
+template <typename Type>
+PrefetchingRange<Type> WithPrefetch(SimpleVector<Type>& vector, size_t distance = kDefaultPrefetchDistance) noexcept {
+    return PrefetchingRange<Type>(vector.AsSpan(), distance);
+}
+
+template <typename Type>
+PrefetchingRange<const Type> WithPrefetch(const SimpleVector<Type>& vector,
+                                          size_t distance = kDefaultPrefetchDistance) noexcept {
+    return PrefetchingRange<const Type>(vector.AsSpan(), distance);
+}
@@ -0,0 +1,21 @@
+#!/bin/sh
+# Собирает и запускает тесты в обычном и усиленном режимах.
+# Компилятор и стандарт можно переопределить: CXX=clang++ STD=c++17 ./run_tests.sh
+set -e
+cd "$(dirname "$0")"
+CXX=${CXX:-g++}
+STD=${STD:-c++20}
+OUT=${TMPDIR:-/tmp}/simple-vector-tests
+
+run() {
+    echo "== $*"
+    "$CXX" -std="$STD" -Wall -pthread "$@" main.cpp -o "$OUT"
+    "$OUT" > /dev/null
+}
+
+run -O2
+run -g -fsanitize=address,undefined -fno-sanitize-recover=all
+run -g -DSIMPLE_VECTOR_HARDENED=1 -fsanitize=address,undefined -fno-sanitize-recover=all
+run -g -DSIMPLE_VECTOR_MEMORY_STATS=1
+run -g -DSIMPLE_VECTOR_MEMORY_STATS=1 -DSIMPLE_VECTOR_HARDENED=1 -fsanitize=address,undefined -fno-sanitize-recover=all
+echo "All configurations passed"
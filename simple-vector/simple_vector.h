@@ -1,48 +1,257 @@
 #pragma once
 #include "array_ptr.h" 
+#include "hash.h"
+#include "span.h"
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <functional>
 #include <initializer_list>
 #include <iterator>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Усиленный режим для отладки: итераторы с проверкой инвалидации,
+// проверка границ в operator[] и (под AddressSanitizer) отравление
+// неиспользуемой части буфера [size_, capacity_).
+// Включается флагом -DSIMPLE_VECTOR_HARDENED=1, по умолчанию выключен,
+// и тогда итераторы остаются обычными указателями
+#ifndef SIMPLE_VECTOR_HARDENED
+#define SIMPLE_VECTOR_HARDENED 0
+#endif
+
+#if SIMPLE_VECTOR_HARDENED
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define SIMPLE_VECTOR_ANNOTATE 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SIMPLE_VECTOR_ANNOTATE 1
+#endif
+#endif
+
+#ifdef SIMPLE_VECTOR_ANNOTATE
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+[[noreturn]] inline void SimpleVectorCheckFailed(const char* message, const char* file, int line) noexcept {
+    std::fprintf(stderr, "%s:%d: SimpleVector check failed: %s\n", file, line, message);
+    std::abort();
+}
+
+// В отличие от assert, работает и при NDEBUG
+#define SIMPLE_VECTOR_CHECK(condition, message) \
+    ((condition) ? (void)0 : SimpleVectorCheckFailed(message, __FILE__, __LINE__))
+#endif
+
+// Учёт памяти векторов в глобальном реестре, см. memory_stats.h
+#ifndef SIMPLE_VECTOR_MEMORY_STATS
+#define SIMPLE_VECTOR_MEMORY_STATS 0
+#endif
+
+#if SIMPLE_VECTOR_MEMORY_STATS
+#include "memory_stats.h"
+#endif
 
 class ReserveProxyObj
 {
 public:
     ReserveProxyObj() = delete;
-    ReserveProxyObj(size_t new_capacity):capacity_to_reserve_(new_capacity){}
+    constexpr ReserveProxyObj(size_t new_capacity):capacity_to_reserve_(new_capacity){}
     size_t capacity_to_reserve_;
 
 };
-ReserveProxyObj Reserve(size_t capacity_to_reserve) {
+inline constexpr ReserveProxyObj Reserve(size_t capacity_to_reserve) {
     return ReserveProxyObj(capacity_to_reserve);
 }
 template <typename Type>
 class SimpleVector {
 public:
+#if SIMPLE_VECTOR_HARDENED
+    // Итератор, помнящий поколение памяти вектора на момент создания.
+    // Разыменование после перевыделения памяти, Insert или Erase,
+    // а также за пределами [begin(), end()) аварийно завершает программу
+    template <typename Value>
+    class CheckedIterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        CheckedIterator() noexcept = default;
+
+        CheckedIterator(Value* ptr, const SimpleVector* owner) noexcept
+            : ptr_(ptr)
+            , owner_(owner)
+            , generation_(owner->generation_) {
+        }
+
+        // Iterator неявно приводится к ConstIterator
+        template <typename Other, typename = std::enable_if_t<std::is_same_v<const Other, Value> && !std::is_same_v<Other, Value>>>
+        CheckedIterator(const CheckedIterator<Other>& other) noexcept
+            : ptr_(other.ptr_)
+            , owner_(other.owner_)
+            , generation_(other.generation_) {
+        }
+
+        Value& operator*() const noexcept {
+            CheckDereferenceable();
+            return *ptr_;
+        }
+
+        Value* operator->() const noexcept {
+            CheckDereferenceable();
+            return ptr_;
+        }
+
+        Value& operator[](difference_type offset) const noexcept {
+            return *(*this + offset);
+        }
+
+        CheckedIterator& operator++() noexcept {
+            ++ptr_;
+            return *this;
+        }
+
+        CheckedIterator operator++(int) noexcept {
+            CheckedIterator old = *this;
+            ++ptr_;
+            return old;
+        }
+
+        CheckedIterator& operator--() noexcept {
+            --ptr_;
+            return *this;
+        }
+
+        CheckedIterator operator--(int) noexcept {
+            CheckedIterator old = *this;
+            --ptr_;
+            return old;
+        }
+
+        CheckedIterator& operator+=(difference_type offset) noexcept {
+            ptr_ += offset;
+            return *this;
+        }
+
+        CheckedIterator& operator-=(difference_type offset) noexcept {
+            ptr_ -= offset;
+            return *this;
+        }
+
+        friend CheckedIterator operator+(CheckedIterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+
+        friend CheckedIterator operator+(difference_type offset, CheckedIterator it) noexcept {
+            return it += offset;
+        }
+
+        friend CheckedIterator operator-(CheckedIterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+
+        friend difference_type operator-(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return lhs.ptr_ - rhs.ptr_;
+        }
+
+        friend bool operator==(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return lhs.ptr_ == rhs.ptr_;
+        }
+
+        friend bool operator!=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return lhs.ptr_ != rhs.ptr_;
+        }
+
+        friend bool operator<(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return lhs.ptr_ < rhs.ptr_;
+        }
+
+        friend bool operator>(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return lhs.ptr_ > rhs.ptr_;
+        }
+
+        friend bool operator<=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return lhs.ptr_ <= rhs.ptr_;
+        }
+
+        friend bool operator>=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return lhs.ptr_ >= rhs.ptr_;
+        }
+
+        friend bool operator==(const CheckedIterator& it, std::nullptr_t) noexcept {
+            return it.ptr_ == nullptr;
+        }
+
+        friend bool operator!=(const CheckedIterator& it, std::nullptr_t) noexcept {
+            return it.ptr_ != nullptr;
+        }
+
+        explicit operator bool() const noexcept {
+            return ptr_ != nullptr;
+        }
+
+    private:
+        template <typename>
+        friend class CheckedIterator;
+        friend class SimpleVector;
+
+        void CheckValid() const noexcept {
+            SIMPLE_VECTOR_CHECK(owner_ != nullptr, "iterator is not bound to a vector");
+            SIMPLE_VECTOR_CHECK(generation_ == owner_->generation_, "iterator used after invalidation");
+        }
+
+        void CheckDereferenceable() const noexcept {
+            CheckValid();
+            const Type* data = owner_->items_.Get();
+            SIMPLE_VECTOR_CHECK(ptr_ >= data && ptr_ < data + owner_->size_, "iterator out of range");
+        }
+
+        Value* ptr_ = nullptr;
+        const SimpleVector* owner_ = nullptr;
+        size_t generation_ = 0;
+    };
+
+    using Iterator = CheckedIterator<Type>;
+    using ConstIterator = CheckedIterator<const Type>;
+#else
     using Iterator = Type*;
     using ConstIterator = const Type*;
+#endif
 
     SimpleVector() noexcept = default;
 
     // Создаёт вектор из size элементов, инициализированных значением по умолчанию
-    explicit SimpleVector(size_t size) :SimpleVector(size, 0) {}
+    SIMPLE_VECTOR_CONSTEXPR explicit SimpleVector(size_t size) :SimpleVector(size, Type()) {}
 
     // Создаёт вектор из size элементов, инициализированных значением value
-    SimpleVector(size_t size, const Type& value) {
+    SIMPLE_VECTOR_CONSTEXPR SimpleVector(size_t size, const Type& value) {
         ArrayPtr<Type> new_items(size);
-        std::fill(&new_items[0], &new_items[size], value);
+        std::fill(new_items.Get(), new_items.Get() + size, value);
         size_ = size;
         capacity_ = size;
         items_.swap(new_items);
+        TrackMemory();
     }
-    SimpleVector(SimpleVector&& other)
+    SIMPLE_VECTOR_CONSTEXPR SimpleVector(SimpleVector&& other)
     {
         items_ = std::move(other.items_);
         size_ = std::exchange(other.size_, 0);
         capacity_ = std::exchange(other.capacity_, 0);
+        other.Invalidate();
+        TrackMemory();
+        other.TrackMemory();
     }
     // Создаёт вектор из std::initializer_list
-    SimpleVector(std::initializer_list<Type> init) {
+    SIMPLE_VECTOR_CONSTEXPR SimpleVector(std::initializer_list<Type> init) {
         size_ = init.size();
         capacity_ = size_;
         ArrayPtr<Type> new_items(size_);
@@ -53,51 +262,75 @@ public:
             new_items[i] = *it;
         }
         items_.swap(new_items);
+        TrackMemory();
+    }
+
+    // Создаёт вектор из ленивого поэлементного выражения (см. expressions.h),
+    // вычисляя его за один проход
+    template <typename Expression, typename = typename Expression::VectorExpressionTag>
+    SimpleVector(const Expression& expression) {
+        Assign(expression);
+    }
+
+    // Оборачивает уже заполненный буфер из size элементов без копирования.
+    // Буфер может быть внешним (см. ArrayPtr с deleter), вместимость равна size
+    SIMPLE_VECTOR_CONSTEXPR SimpleVector(ArrayPtr<Type>&& items, size_t size) noexcept
+        : items_(std::move(items))
+        , size_(size)
+        , capacity_(size)
+    {
+        TrackMemory();
     }
 
     // Создает вектор с зарезервируемым количеством элементов
-    SimpleVector(ReserveProxyObj obj)
+    SIMPLE_VECTOR_CONSTEXPR SimpleVector(ReserveProxyObj obj)
     {
         this->Reserve(obj.capacity_to_reserve_);
     }
 
-    ~SimpleVector()
+    SIMPLE_VECTOR_CONSTEXPR ~SimpleVector()
     {
-        //items_.Release();
+        Unpoison();
     }
 
     // Возвращает количество элементов в массиве
-    size_t GetSize() const noexcept {
+    SIMPLE_VECTOR_CONSTEXPR size_t GetSize() const noexcept {
         // Напишите тело самостоятельно
         return size_;
     }
 
     // Возвращает вместимость массива
-    size_t GetCapacity() const noexcept {
+    SIMPLE_VECTOR_CONSTEXPR size_t GetCapacity() const noexcept {
         // Напишите тело самостоятельно
         return capacity_;
     }
 
     // Сообщает, пустой ли массив
-    bool IsEmpty() const noexcept {
+    SIMPLE_VECTOR_CONSTEXPR bool IsEmpty() const noexcept {
         return size_ == 0;
     }
 
     // Возвращает ссылку на элемент с индексом index
-    Type& operator[](size_t index) noexcept {
+    SIMPLE_VECTOR_CONSTEXPR Type& operator[](size_t index) noexcept {
         assert(index < size_);
+#if SIMPLE_VECTOR_HARDENED
+        SIMPLE_VECTOR_CHECK(index < size_, "index out of range");
+#endif
         return items_[index];
     }
 
     // Возвращает константную ссылку на элемент с индексом index
-    const Type& operator[](size_t index) const noexcept {
+    SIMPLE_VECTOR_CONSTEXPR const Type& operator[](size_t index) const noexcept {
         assert(index < size_);
+#if SIMPLE_VECTOR_HARDENED
+        SIMPLE_VECTOR_CHECK(index < size_, "index out of range");
+#endif
         return items_[index];
     }
 
     // Возвращает константную ссылку на элемент с индексом index
     // Выбрасывает исключение std::out_of_range, если index >= size
-    Type& At(size_t index) {
+    SIMPLE_VECTOR_CONSTEXPR Type& At(size_t index) {
         if (index >= size_)
         {
             throw std::out_of_range("out of range");
@@ -107,7 +340,7 @@ public:
 
     // Возвращает константную ссылку на элемент с индексом index
     // Выбрасывает исключение std::out_of_range, если index >= size
-    const Type& At(size_t index) const {
+    SIMPLE_VECTOR_CONSTEXPR const Type& At(size_t index) const {
         if (index >= size_)
         {
             throw std::out_of_range("out of range");
@@ -116,189 +349,461 @@ public:
     }
 
     // Обнуляет размер массива, не изменяя его вместимость
-    void Clear() noexcept {
+    SIMPLE_VECTOR_CONSTEXPR void Clear() noexcept {
+        PoisonGuard guard(*this);
+        ResetUnused(0);
         size_ = 0;
     }
 
-    void Reserve(size_t new_capacity)
+    SIMPLE_VECTOR_CONSTEXPR void Reserve(size_t new_capacity)
     {
         if (new_capacity <= capacity_)
         {
             return;
         }
-        ArrayPtr<Type> new_array(new_capacity);
-        std::copy(&items_[0], &items_[size_], &new_array[0]);
-        items_.swap(new_array);
-        capacity_ = new_capacity;
+        PoisonGuard guard(*this);
+        Reallocate(new_capacity);
+    }
+    // Уменьшает вместимость до размера, освобождая неиспользуемую память.
+    // Для пустого вектора память освобождается полностью
+    SIMPLE_VECTOR_CONSTEXPR void ShrinkToFit()
+    {
+        if (capacity_ == size_)
+        {
+            return;
+        }
+        PoisonGuard guard(*this);
+        Reallocate(size_);
     }
+
     // Изменяет размер массива.
     // При увеличении размера новые элементы получают значение по умолчанию для типа Type
-    void Resize(size_t new_size) {
-        // Напишите тело самостоятельно
-        if (new_size < capacity_)
+    SIMPLE_VECTOR_CONSTEXPR void Resize(size_t new_size) {
+        PoisonGuard guard(*this);
+        if (new_size > capacity_)
         {
-            this->Fill(&items_[size_], &items_[capacity_], Type());
-            
+            Reallocate(std::max(new_size, 2 * capacity_));
+        }
+        if (new_size > size_)
+        {
+            this->Fill(items_.Get() + size_, items_.Get() + new_size, Type());
         }
         else
         {
-            auto new_capacity = std::max(new_size, 2 * capacity_);
-            ArrayPtr<Type> new_array(new_capacity);
-            std::move(&items_[0], &items_[size_], &new_array[0]);
-            this->Fill(&new_array[size_], &new_array[new_size], Type());
-            items_.swap(new_array);
-            (void)new_array.Release();
-            capacity_ = new_capacity;
+            ResetUnused(new_size);
         }
         size_ = new_size;
     }
 
     // Возвращает итератор на начало массива
     // Для пустого массива может быть равен (или не равен) nullptr
-    Iterator begin() noexcept {
-        return Iterator{ &items_[0] };
+    SIMPLE_VECTOR_CONSTEXPR Iterator begin() noexcept {
+        return MakeIterator(items_.Get());
     }
 
     // Возвращает итератор на элемент, следующий за последним
     // Для пустого массива может быть равен (или не равен) nullptr
-    Iterator end() noexcept {
-        return Iterator{ &items_[size_] };
+    SIMPLE_VECTOR_CONSTEXPR Iterator end() noexcept {
+        return MakeIterator(items_.Get() + size_);
     }
 
     // Возвращает константный итератор на начало массива
     // Для пустого массива может быть равен (или не равен) nullptr
-    ConstIterator begin() const noexcept {
-        return ConstIterator{ &items_[0] };
+    SIMPLE_VECTOR_CONSTEXPR ConstIterator begin() const noexcept {
+        return MakeIterator(static_cast<const Type*>(items_.Get()));
     }
 
     // Возвращает итератор на элемент, следующий за последним
     // Для пустого массива может быть равен (или не равен) nullptr
-    ConstIterator end() const noexcept {
-        return ConstIterator{ &items_[size_] };
+    SIMPLE_VECTOR_CONSTEXPR ConstIterator end() const noexcept {
+        return MakeIterator(static_cast<const Type*>(items_.Get() + size_));
     }
 
     // Возвращает константный итератор на начало массива
     // Для пустого массива может быть равен (или не равен) nullptr
-    ConstIterator cbegin() const noexcept {
+    SIMPLE_VECTOR_CONSTEXPR ConstIterator cbegin() const noexcept {
         return begin();
     }
 
     // Возвращает итератор на элемент, следующий за последним
     // Для пустого массива может быть равен (или не равен) nullptr
-    ConstIterator cend() const noexcept {
+    SIMPLE_VECTOR_CONSTEXPR ConstIterator cend() const noexcept {
         return end();
     }
 
-    SimpleVector(const SimpleVector& other) {
+    // Возвращает 64-битный хеш содержимого.
+    // Для типов без байтов-заполнителей память хешируется целиком, см. hash.h
+    uint64_t Hash() const noexcept {
+        return HashElements(static_cast<const Type*>(items_.Get()), size_);
+    }
+
+    // Возвращает невладеющее представление элементов вектора.
+    // Становится недействительным после перевыделения памяти
+    SIMPLE_VECTOR_CONSTEXPR Span<Type> AsSpan() noexcept {
+        return Span<Type>(items_.Get(), size_);
+    }
+
+    SIMPLE_VECTOR_CONSTEXPR ConstSpan<Type> AsSpan() const noexcept {
+        return ConstSpan<Type>(items_.Get(), size_);
+    }
+
+    SIMPLE_VECTOR_CONSTEXPR operator Span<Type>() noexcept {
+        return AsSpan();
+    }
+
+    SIMPLE_VECTOR_CONSTEXPR operator ConstSpan<Type>() const noexcept {
+        return AsSpan();
+    }
+
+    SIMPLE_VECTOR_CONSTEXPR SimpleVector(const SimpleVector& other) {
         CopyAndSwap(other);
     }
 
-    SimpleVector& operator=(const SimpleVector& rhs) {
+    SIMPLE_VECTOR_CONSTEXPR SimpleVector& operator=(const SimpleVector& rhs) {
         if (this != &rhs)
         {
             CopyAndSwap(rhs);
         }
         return *this;
     }
-    // Добавляет элемент в конец вектора
-    // При нехватке места увеличивает вдвое вместимость вектора
-    void PushBack(const Type& item) {
-        if (IsEmpty())
+    template <typename Expression, typename = typename Expression::VectorExpressionTag>
+    SimpleVector& operator=(const Expression& expression) {
+        Assign(expression);
+        return *this;
+    }
+
+    // Вычисляет ленивое выражение и записывает результат в вектор.
+    // Если вместимости хватает, запись идёт на месте без выделения памяти.
+    // При parallel == true большие выражения вычисляются в нескольких потоках
+    template <typename Expression, typename = typename Expression::VectorExpressionTag>
+    void Assign(const Expression& expression, bool parallel = false) {
+        PoisonGuard guard(*this);
+        const size_t new_size = expression.GetSize();
+        if (new_size <= capacity_)
         {
-            ArrayPtr<Type> new_items(1);
-            items_.swap(new_items);
+            expression.EvaluateInto(items_.Get(), parallel);
+            if (new_size < size_)
+            {
+                ResetUnused(new_size);
+            }
         }
-        items_[size_] = std::move(item);
-        size_++;
-        if (size_ > capacity_) {
-            Resize(size_);
+        else
+        {
+            ArrayPtr<Type> new_items(new_size);
+            expression.EvaluateInto(new_items.Get(), parallel);
+            items_.swap(new_items);
+            capacity_ = new_size;
+            Invalidate();
+            TrackMemory();
         }
+        size_ = new_size;
     }
+
     // Добавляет элемент в конец вектора
     // При нехватке места увеличивает вдвое вместимость вектора
-    void PushBack(Type&& item) {
-        if (IsEmpty())
-        {
-            ArrayPtr<Type> new_items(1);
-            items_.swap(new_items);
-        }
-        items_[size_] = std::move(item);
-        size_++;
-        if (size_ > capacity_) {
-            Resize(size_);
-        }
+    SIMPLE_VECTOR_CONSTEXPR void PushBack(const Type& item) {
+        Append(item);
+    }
+    // Добавляет элемент в конец вектора
+    // При нехватке места увеличивает вдвое вместимость вектора
+    SIMPLE_VECTOR_CONSTEXPR void PushBack(Type&& item) {
+        Append(std::move(item));
     }
 
     // Вставляет значение value в позицию pos.
     // Возвращает итератор на вставленное значение
     // Если перед вставкой значения вектор был заполнен полностью,
     // вместимость вектора должна увеличиться вдвое, а для вектора вместимостью 0 стать равной 1
-    Iterator Insert(ConstIterator pos, Type&& value) {
-        assert(pos >= begin() && pos <= end());
-        auto dist = this->end() - pos;
-        auto length_dist = pos - this->begin();
-        if (IsEmpty())
+    SIMPLE_VECTOR_CONSTEXPR Iterator Insert(ConstIterator pos, Type&& value) {
+        const size_t index = IndexOf(pos);
+        // value может ссылаться на элемент этого же вектора, который
+        // сдвинется или будет освобождён вместе со старым буфером
+        Type item(std::move(value));
+        PoisonGuard guard(*this);
+        if (size_ == capacity_)
         {
-            ArrayPtr<Type> new_items(1);
-            items_.swap(new_items);
-            items_[length_dist] = std::move(value);
-        }
-        else
-        {
-            ArrayPtr<Type> copy_arr(dist);
-            std::move(&items_[length_dist], &items_[size_], &copy_arr[0]);
-            items_[length_dist] = std::move(value);
-            std::move(&copy_arr[0], &copy_arr[dist], &items_[length_dist + 1]);
+            Reallocate(capacity_ == 0 ? 1 : 2 * capacity_);
         }
-
+        Type* items = items_.Get();
+        std::move_backward(items + index, items + size_, items + size_ + 1);
+        items[index] = std::move(item);
         size_++;
-        if (size_ > capacity_) {
-            Resize(size_);
-        }
-        return Iterator{&items_[length_dist]};
+        Invalidate();
+        return MakeIterator(items + index);
     }
 
     // "Удаляет" последний элемент вектора. Вектор не должен быть пустым
-    void PopBack() noexcept {
+    SIMPLE_VECTOR_CONSTEXPR void PopBack() noexcept {
         if (!IsEmpty())
         {
+            PoisonGuard guard(*this);
+            ResetUnused(size_ - 1);
             size_ --;
         }
     }
 
     // Удаляет элемент вектора в указанной позиции
-    Iterator Erase(ConstIterator pos) {
-        assert(pos >= begin() && pos <= end());
+    SIMPLE_VECTOR_CONSTEXPR Iterator Erase(ConstIterator pos) {
         if (IsEmpty())
         {
             return {};
         }
-        auto dist = this->end() - pos;
-        auto length_dist = pos - this->begin();
-        ArrayPtr<Type> copy_arr(dist);
-        std::move(&items_[length_dist + 1], &items_[size_], &copy_arr[0]);
-        std::move(&copy_arr[0], &copy_arr[dist], &items_[length_dist]);
+        const size_t index = IndexOf(pos);
+        assert(index < size_);
+#if SIMPLE_VECTOR_HARDENED
+        // IndexOf допускает end() ради Insert, но удалять end() нельзя
+        SIMPLE_VECTOR_CHECK(index < size_, "erase position out of range");
+#endif
+        PoisonGuard guard(*this);
+        Type* items = items_.Get();
+        std::move(items + index + 1, items + size_, items + index);
+        ResetUnused(size_ - 1);
         size_--;
-        Resize(size_);
-        return Iterator{ &items_[length_dist] };
+        Invalidate();
+        return MakeIterator(items + index);
+    }
+
+    // Удаляет все элементы, для которых pred возвращает true.
+    // Оставшиеся элементы сдвигаются за один проход без выделения памяти.
+    // Возвращает количество удалённых элементов
+    template <typename Predicate>
+    SIMPLE_VECTOR_CONSTEXPR size_t EraseIf(Predicate pred) {
+        Type* items = items_.Get();
+        Type* new_end = std::remove_if(items, items + size_, pred);
+        return Truncate(static_cast<size_t>(new_end - items));
+    }
+
+    // Удаляет подряд идущие повторы, оставляя первый элемент каждой группы.
+    // Возвращает количество удалённых элементов
+    template <typename BinaryPredicate = std::equal_to<>>
+    SIMPLE_VECTOR_CONSTEXPR size_t Unique(BinaryPredicate pred = BinaryPredicate{}) {
+        Type* items = items_.Get();
+        Type* new_end = std::unique(items, items + size_, pred);
+        return Truncate(static_cast<size_t>(new_end - items));
+    }
+
+    // Удаляет элементы с индексами из sorted_indices, которые должны строго возрастать.
+    // Участки между удаляемыми элементами сдвигаются целиком за один проход.
+    // Возвращает количество удалённых элементов
+    SIMPLE_VECTOR_CONSTEXPR size_t RemoveIndices(ConstSpan<size_t> sorted_indices) {
+        const size_t count = sorted_indices.GetSize();
+        if (count == 0)
+        {
+            return 0;
+        }
+        Type* items = items_.Get();
+        Type* write = items + sorted_indices[0];
+        for (size_t i = 0; i < count; ++i)
+        {
+            const size_t first = sorted_indices[i] + 1;
+            const size_t last = i + 1 < count ? sorted_indices[i + 1] : size_;
+            assert(first <= last && last <= size_);
+#if SIMPLE_VECTOR_HARDENED
+            SIMPLE_VECTOR_CHECK(first <= last && last <= size_, "indices must be sorted and in range");
+#endif
+            write = std::move(items + first, items + last, write);
+        }
+        return Truncate(static_cast<size_t>(write - items));
+    }
+
+    // Переставляет элементы так, что удовлетворяющие pred идут первыми,
+    // сохраняя относительный порядок внутри обеих групп.
+    // Работает на месте без выделения памяти за O(n log n) перемещений.
+    // Возвращает итератор на первый элемент второй группы
+    template <typename Predicate>
+    SIMPLE_VECTOR_CONSTEXPR Iterator StablePartition(Predicate pred) {
+        Type* items = items_.Get();
+        return MakeIterator(StablePartitionRange(items, items + size_, pred));
     }
 
     // Обменивает значение с другим вектором
-    void swap(SimpleVector& other) noexcept {
+    SIMPLE_VECTOR_CONSTEXPR void swap(SimpleVector& other) noexcept {
         this->items_.swap(other.items_);
         std::swap(this->size_, other.size_);
         std::swap(this->capacity_, other.capacity_);
+        Invalidate();
+        other.Invalidate();
+        TrackMemory();
+        other.TrackMemory();
     }
 private:
-    void CopyAndSwap(const SimpleVector &other)
+    // Снимает отравление неиспользуемой части буфера на время изменения вектора
+    // и восстанавливает его для нового буфера и размера при выходе из области видимости
+    class PoisonGuard {
+    public:
+        SIMPLE_VECTOR_CONSTEXPR explicit PoisonGuard(SimpleVector& vector) noexcept
+            : vector_(vector) {
+            vector_.Unpoison();
+        }
+        PoisonGuard(const PoisonGuard&) = delete;
+        PoisonGuard& operator=(const PoisonGuard&) = delete;
+        SIMPLE_VECTOR_CONSTEXPR ~PoisonGuard() {
+            vector_.Poison();
+        }
+
+    private:
+        SimpleVector& vector_;
+    };
+
+    SIMPLE_VECTOR_CONSTEXPR void CopyAndSwap(const SimpleVector &other)
     {
-        SimpleVector copy_vector(other.GetSize());
-        std::copy(other.begin(), other.end(), copy_vector.begin());
-        copy_vector.capacity_ = other.capacity_;
+        // Копия получает ровно столько памяти, сколько занимают элементы
+        SimpleVector copy_vector(ReserveProxyObj(other.size_));
+        {
+            PoisonGuard guard(copy_vector);
+            std::copy(other.items_.Get(), other.items_.Get() + other.size_, copy_vector.items_.Get());
+            copy_vector.size_ = other.size_;
+        }
         this->swap(copy_vector);
     }
+
+    // Уменьшает размер до new_size, возвращает количество отброшенных элементов
+    SIMPLE_VECTOR_CONSTEXPR size_t Truncate(size_t new_size) noexcept
+    {
+        const size_t removed = size_ - new_size;
+        if (removed != 0)
+        {
+            PoisonGuard guard(*this);
+            ResetUnused(new_size);
+            size_ = new_size;
+            Invalidate();
+        }
+        return removed;
+    }
+
+    template <typename Predicate>
+    static SIMPLE_VECTOR_CONSTEXPR Type* StablePartitionRange(Type* first, Type* last, Predicate& pred)
+    {
+        // Элементы в начале, уже стоящие на своих местах, не трогаем
+        while (first != last && pred(*first))
+        {
+            ++first;
+        }
+        if (last - first <= 1)
+        {
+            return first;
+        }
+        Type* middle = first + (last - first) / 2;
+        Type* left_end = StablePartitionRange(first, middle, pred);
+        Type* right_end = StablePartitionRange(middle, last, pred);
+        return std::rotate(left_end, middle, right_end);
+    }
+
+    // Переносит элементы в новый буфер вместимостью new_capacity
+    // Добавляет элемент в конец. item может ссылаться на элемент этого же вектора,
+    // поэтому при переполнении он записывается в новый буфер до освобождения старого
+    template <typename Item>
+    SIMPLE_VECTOR_CONSTEXPR void Append(Item&& item) {
+        PoisonGuard guard(*this);
+        if (size_ == capacity_)
+        {
+            const size_t new_capacity = capacity_ == 0 ? 1 : 2 * capacity_;
+            ArrayPtr<Type> new_array(new_capacity);
+            new_array[size_] = std::forward<Item>(item);
+            std::move(items_.Get(), items_.Get() + size_, new_array.Get());
+            items_.swap(new_array);
+            capacity_ = new_capacity;
+            Invalidate();
+            TrackMemory();
+        }
+        else
+        {
+            items_[size_] = std::forward<Item>(item);
+        }
+        size_++;
+    }
+
+    SIMPLE_VECTOR_CONSTEXPR void Reallocate(size_t new_capacity)
+    {
+        ArrayPtr<Type> new_array(new_capacity);
+        std::move(items_.Get(), items_.Get() + size_, new_array.Get());
+        items_.swap(new_array);
+        capacity_ = new_capacity;
+        Invalidate();
+        TrackMemory();
+    }
+
+    // Элементы [new_size, size_) уходят в неиспользуемую часть буфера.
+    // Они заменяются значением по умолчанию и сразу освобождают свои ресурсы,
+    // например память вложенных векторов, а не держат её до перезаписи
+    SIMPLE_VECTOR_CONSTEXPR void ResetUnused(size_t new_size) noexcept {
+        if constexpr (!std::is_trivially_destructible_v<Type> && std::is_nothrow_default_constructible_v<Type>
+                      && std::is_nothrow_swappable_v<Type>)
+        {
+            using std::swap;
+            for (size_t i = new_size; i < size_; ++i)
+            {
+                Type empty{};
+                swap(items_[i], empty);
+            }
+        }
+    }
+
+    // Вектор числится в реестре учёта памяти, только пока владеет буфером
+    SIMPLE_VECTOR_CONSTEXPR void TrackMemory() noexcept {
+#if SIMPLE_VECTOR_MEMORY_STATS
+        memory_node_.Track(capacity_ != 0);
+#endif
+    }
+
+    // Отмечает все выданные итераторы недействительными
+    SIMPLE_VECTOR_CONSTEXPR void Invalidate() noexcept {
+#if SIMPLE_VECTOR_HARDENED
+        ++generation_;
+#endif
+    }
+
+    SIMPLE_VECTOR_CONSTEXPR void Poison() noexcept {
+#ifdef SIMPLE_VECTOR_ANNOTATE
+        AnnotateUnused(capacity_, size_);
+#endif
+    }
+
+    SIMPLE_VECTOR_CONSTEXPR void Unpoison() noexcept {
+#ifdef SIMPLE_VECTOR_ANNOTATE
+        AnnotateUnused(size_, capacity_);
+#endif
+    }
+
+#ifdef SIMPLE_VECTOR_ANNOTATE
+    // Сообщает AddressSanitizer, что граница доступной памяти сдвинулась с old_mid на new_mid
+    void AnnotateUnused(size_t old_mid, size_t new_mid) const noexcept {
+        const Type* data = items_.Get();
+        if (data == nullptr || capacity_ == 0 || reinterpret_cast<std::uintptr_t>(data) % 8 != 0)
+        {
+            return;
+        }
+        __sanitizer_annotate_contiguous_container(data, data + capacity_, data + old_mid, data + new_mid);
+    }
+#endif
+
+#if SIMPLE_VECTOR_HARDENED
+    template <typename Value>
+    CheckedIterator<Value> MakeIterator(Value* ptr) const noexcept {
+        return CheckedIterator<Value>(ptr, this);
+    }
+
+    // Возвращает индекс позиции pos, проверяя, что итератор принадлежит вектору и не устарел
+    size_t IndexOf(ConstIterator pos) const noexcept {
+        pos.CheckValid();
+        SIMPLE_VECTOR_CHECK(pos.owner_ == this, "iterator belongs to another vector");
+        const size_t index = static_cast<size_t>(pos.ptr_ - items_.Get());
+        SIMPLE_VECTOR_CHECK(index <= size_, "iterator out of range");
+        return index;
+    }
+#else
+    template <typename Value>
+    SIMPLE_VECTOR_CONSTEXPR static Value* MakeIterator(Value* ptr) noexcept {
+        return ptr;
+    }
+
+    SIMPLE_VECTOR_CONSTEXPR size_t IndexOf(ConstIterator pos) const noexcept {
+        assert(pos >= items_.Get() && pos <= items_.Get() + size_);
+        return static_cast<size_t>(pos - items_.Get());
+    }
+#endif
     template <typename It>
-    void Fill(It begin, It end, Type& value)
+    SIMPLE_VECTOR_CONSTEXPR void Fill(It begin, It end, Type& value)
     {
         for (auto it = begin; it != end; it++)
         {
@@ -306,7 +811,7 @@ private:
         }
     }
     template <typename It>
-    void Fill(It begin, It end, Type&& value)
+    SIMPLE_VECTOR_CONSTEXPR void Fill(It begin, It end, Type&& value)
     {
         (void)value;
         for (auto it = begin; it != end; it++)
@@ -322,43 +827,92 @@ private:
 
     size_t size_ = 0;
     size_t capacity_ = 0;
+#if SIMPLE_VECTOR_HARDENED
+    // Увеличивается при каждом событии, делающем итераторы недействительными
+    size_t generation_ = 0;
+#endif
+#if SIMPLE_VECTOR_MEMORY_STATS
+    static void CollectMemoryStats(const void* owner, size_t& used_bytes, size_t& reserved_bytes) noexcept
+    {
+        const SimpleVector* vector = static_cast<const SimpleVector*>(owner);
+        used_bytes = vector->size_ * sizeof(Type);
+        reserved_bytes = vector->capacity_ * sizeof(Type);
+    }
 
+    static size_t TrimMemory(void* owner)
+    {
+        SimpleVector* vector = static_cast<SimpleVector*>(owner);
+        const size_t old_capacity = vector->capacity_;
+        vector->ShrinkToFit();
+        return (old_capacity - vector->capacity_) * sizeof(Type);
+    }
+
+    // Не копируется и не обменивается: каждый объект вектора регистрируется сам, см. TrackMemory
+    VectorMemoryNode memory_node_{this, &CollectMemoryStats, &TrimMemory};
+#endif
 
 };
+// Обмен через swap, найденный поиском по аргументам, не копирует элементы:
+// у SimpleVector нет перемещающего присваивания, и std::swap копировал бы векторы
+template <typename Type>
+inline SIMPLE_VECTOR_CONSTEXPR void swap(SimpleVector<Type>& lhs, SimpleVector<Type>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
 template <typename Type>
-inline bool operator==(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
+inline SIMPLE_VECTOR_CONSTEXPR bool operator==(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
     // Заглушка. Напишите тело самостоятельно
 
-    return (std::equal(lhs.begin(), lhs.end(), rhs.begin())) && (lhs.GetSize() == rhs.GetSize());
+    return (lhs.GetSize() == rhs.GetSize()) && (std::equal(lhs.begin(), lhs.end(), rhs.begin()));
 
 }
 
 template <typename Type>
-inline bool operator!=(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
+inline SIMPLE_VECTOR_CONSTEXPR bool operator!=(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
     // Заглушка. Напишите тело самостоятельно
     return !(lhs == rhs);
 }
 
 template <typename Type>
-inline bool operator<(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
+inline SIMPLE_VECTOR_CONSTEXPR bool operator<(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
     // Заглушка. Напишите тело самостоятельно
     return (std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()));
 }
 
 template <typename Type>
-inline bool operator<=(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
+inline SIMPLE_VECTOR_CONSTEXPR bool operator<=(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
     // Заглушка. Напишите тело самостоятельно
     return !(rhs < lhs);
 }
 
 template <typename Type>
-inline bool operator>(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
+inline SIMPLE_VECTOR_CONSTEXPR bool operator>(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
     // Заглушка. Напишите тело самостоятельно
     return rhs < lhs;
 }
 
 template <typename Type>
-inline bool operator>=(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
+inline SIMPLE_VECTOR_CONSTEXPR bool operator>=(const SimpleVector<Type>& lhs, const SimpleVector<Type>& rhs) {
     // Заглушка. Напишите тело самостоятельно
     return !(lhs < rhs);
-}
\ No newline at end of file
+}
+
+// Копирует вектор, построенный функцией builder, в std::array<Type, N>.
+// Память SimpleVector не может пережить constexpr-вычисление, а std::array может,
+// поэтому так таблицу можно построить на этапе компиляции и сохранить в программе:
+// constexpr auto kTable = ToArray<16>([] { SimpleVector<int> v; ...; return v; });
+// Выбрасывает std::length_error (при компиляции - ошибка), если размер вектора не равен N
+template <size_t N, typename Builder>
+constexpr auto ToArray(Builder builder) {
+    const auto vector = builder();
+    using Type = typename std::iterator_traits<typename std::remove_cv_t<decltype(vector)>::Iterator>::value_type;
+    if (vector.GetSize() != N)
+    {
+        throw std::length_error("table size mismatch");
+    }
+    std::array<Type, N> table{};
+    for (size_t i = 0; i < N; ++i) {
+        table[i] = vector[i];
+    }
+    return table;
+}
@@ -0,0 +1,199 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+template <typename Type>
+class StridedSpan;
+
+// Невладеющее представление непрерывного участка памяти.
+// Копируется дёшево, не продлевает жизнь данных и становится
+// недействительным после перевыделения памяти владельца
+template <typename Type>
+class Span {
+public:
+    using Iterator = Type*;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    Span() noexcept = default;
+
+    constexpr Span(Type* data, size_t size) noexcept
+        : data_(data)
+        , size_(size) {
+    }
+
+    // Позволяет передавать Span<T> туда, где ожидается Span<const T>
+    template <typename Other, typename = std::enable_if_t<std::is_convertible_v<Other (*)[], Type (*)[]>>>
+    constexpr Span(Span<Other> other) noexcept
+        : data_(other.GetData())
+        , size_(other.GetSize()) {
+    }
+
+    constexpr Type* GetData() const noexcept {
+        return data_;
+    }
+
+    constexpr size_t GetSize() const noexcept {
+        return size_;
+    }
+
+    constexpr bool IsEmpty() const noexcept {
+        return size_ == 0;
+    }
+
+    constexpr Type& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return data_[index];
+    }
+
+    constexpr Iterator begin() const noexcept {
+        return data_;
+    }
+
+    constexpr Iterator end() const noexcept {
+        return data_ + size_;
+    }
+
+    // Возвращает count элементов, начиная с offset.
+    // Если count == npos, берутся все элементы до конца
+    constexpr Span Subspan(size_t offset, size_t count = npos) const noexcept {
+        assert(offset <= size_);
+        if (count == npos) {
+            count = size_ - offset;
+        }
+        assert(count <= size_ - offset);
+        return Span(data_ + offset, count);
+    }
+
+    // Возвращает первые count элементов
+    constexpr Span First(size_t count) const noexcept {
+        assert(count <= size_);
+        return Span(data_, count);
+    }
+
+    // Возвращает последние count элементов
+    constexpr Span Last(size_t count) const noexcept {
+        assert(count <= size_);
+        return Span(data_ + (size_ - count), count);
+    }
+
+    // Возвращает каждый step-й элемент, начиная с первого
+    constexpr StridedSpan<Type> Stride(size_t step) const noexcept {
+        assert(step > 0);
+        return StridedSpan<Type>(data_, (size_ + step - 1) / step, step);
+    }
+
+private:
+    Type* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+template <typename Type>
+using ConstSpan = Span<const Type>;
+
+// Невладеющее представление элементов, отстоящих друг от друга на stride позиций,
+// например столбца матрицы, хранящейся по строкам
+template <typename Type>
+class StridedSpan {
+public:
+    // Итератор хранит количество оставшихся элементов, а не указатель-ограничитель:
+    // адрес data + size * stride может лежать дальше, чем за последним элементом,
+    // и даже вычислять его - неопределённое поведение
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_cv_t<Type>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Type*;
+        using reference = Type&;
+
+        Iterator() noexcept = default;
+
+        constexpr Iterator(Type* ptr, size_t stride, size_t remaining) noexcept
+            : ptr_(ptr)
+            , stride_(stride)
+            , remaining_(remaining) {
+        }
+
+        constexpr Type& operator*() const noexcept {
+            assert(remaining_ > 0);
+            return *ptr_;
+        }
+
+        constexpr Type* operator->() const noexcept {
+            assert(remaining_ > 0);
+            return ptr_;
+        }
+
+        constexpr Iterator& operator++() noexcept {
+            assert(remaining_ > 0);
+            // После последнего элемента указатель остаётся на месте
+            if (--remaining_ > 0) {
+                ptr_ += stride_;
+            }
+            return *this;
+        }
+
+        constexpr Iterator operator++(int) noexcept {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        // Сравнивать можно только итераторы одного представления
+        constexpr bool operator==(const Iterator& other) const noexcept {
+            return remaining_ == other.remaining_;
+        }
+
+        constexpr bool operator!=(const Iterator& other) const noexcept {
+            return remaining_ != other.remaining_;
+        }
+
+    private:
+        Type* ptr_ = nullptr;
+        size_t stride_ = 1;
+        size_t remaining_ = 0;
+    };
+
+    StridedSpan() noexcept = default;
+
+    // size - количество элементов в представлении, а не длина памяти
+    constexpr StridedSpan(Type* data, size_t size, size_t stride) noexcept
+        : data_(data)
+        , size_(size)
+        , stride_(stride) {
+        assert(stride > 0);
+    }
+
+    constexpr size_t GetSize() const noexcept {
+        return size_;
+    }
+
+    constexpr size_t GetStride() const noexcept {
+        return stride_;
+    }
+
+    constexpr bool IsEmpty() const noexcept {
+        return size_ == 0;
+    }
+
+    constexpr Type& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return data_[index * stride_];
+    }
+
+    constexpr Iterator begin() const noexcept {
+        return Iterator(data_, stride_, size_);
+    }
+
+    constexpr Iterator end() const noexcept {
+        return Iterator(data_, stride_, 0);
+    }
+
+private:
+    Type* data_ = nullptr;
+    size_t size_ = 0;
+    size_t stride_ = 1;
+};
@@ -0,0 +1,335 @@
+#pragma once
+#include "span.h"
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if !defined(__cpp_concepts) || __cpp_concepts < 201907L
+#error "static_vector.h requires C++20"
+#endif
+
+// Вектор фиксированной вместимости N с тем же интерфейсом, что и SimpleVector.
+// Элементы хранятся внутри объекта в неинициализированной памяти и создаются
+// по мере добавления, поэтому куча не используется вовсе.
+// Если Type тривиально копируемый, StaticVector тоже тривиально копируемый
+template <typename Type, size_t N>
+class StaticVector {
+    static_assert(N > 0, "StaticVector capacity must be positive");
+
+public:
+    using Iterator = Type*;
+    using ConstIterator = const Type*;
+
+    StaticVector() noexcept {
+    }
+
+    // Создаёт вектор из size элементов, инициализированных значением по умолчанию
+    explicit StaticVector(size_t size) {
+        Resize(size);
+    }
+
+    // Создаёт вектор из size элементов, инициализированных значением value
+    StaticVector(size_t size, const Type& value) {
+        CheckCapacity(size);
+        std::uninitialized_fill_n(items_, size, value);
+        size_ = size;
+    }
+
+    // Создаёт вектор из std::initializer_list
+    StaticVector(std::initializer_list<Type> init) {
+        CheckCapacity(init.size());
+        std::uninitialized_copy(init.begin(), init.end(), items_);
+        size_ = init.size();
+    }
+
+    StaticVector(const StaticVector&) requires std::is_trivially_copy_constructible_v<Type> = default;
+
+    StaticVector(const StaticVector& other) {
+        std::uninitialized_copy(other.begin(), other.end(), items_);
+        size_ = other.size_;
+    }
+
+    StaticVector(StaticVector&&) requires std::is_trivially_move_constructible_v<Type> = default;
+
+    StaticVector(StaticVector&& other) noexcept(std::is_nothrow_move_constructible_v<Type>) {
+        std::uninitialized_move(other.begin(), other.end(), items_);
+        size_ = other.size_;
+    }
+
+    StaticVector& operator=(const StaticVector&) requires std::is_trivially_copy_assignable_v<Type> = default;
+
+    StaticVector& operator=(const StaticVector& rhs) {
+        if (this != &rhs)
+        {
+            Assign(rhs.begin(), rhs.end());
+        }
+        return *this;
+    }
+
+    StaticVector& operator=(StaticVector&&) requires std::is_trivially_move_assignable_v<Type> = default;
+
+    StaticVector& operator=(StaticVector&& rhs) noexcept(std::is_nothrow_move_assignable_v<Type>) {
+        if (this != &rhs)
+        {
+            Assign(std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
+        }
+        return *this;
+    }
+
+    ~StaticVector() requires std::is_trivially_destructible_v<Type> = default;
+
+    ~StaticVector() {
+        std::destroy_n(items_, size_);
+    }
+
+    // Возвращает количество элементов в массиве
+    size_t GetSize() const noexcept {
+        return size_;
+    }
+
+    // Возвращает вместимость массива, она всегда равна N
+    static constexpr size_t GetCapacity() noexcept {
+        return N;
+    }
+
+    // Сообщает, пустой ли массив
+    bool IsEmpty() const noexcept {
+        return size_ == 0;
+    }
+
+    // Возвращает ссылку на элемент с индексом index
+    Type& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return items_[index];
+    }
+
+    // Возвращает константную ссылку на элемент с индексом index
+    const Type& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return items_[index];
+    }
+
+    // Возвращает ссылку на элемент с индексом index
+    // Выбрасывает исключение std::out_of_range, если index >= size
+    Type& At(size_t index) {
+        if (index >= size_)
+        {
+            throw std::out_of_range("out of range");
+        }
+        return items_[index];
+    }
+
+    // Возвращает константную ссылку на элемент с индексом index
+    // Выбрасывает исключение std::out_of_range, если index >= size
+    const Type& At(size_t index) const {
+        if (index >= size_)
+        {
+            throw std::out_of_range("out of range");
+        }
+        return items_[index];
+    }
+
+    // Удаляет все элементы
+    void Clear() noexcept {
+        std::destroy_n(items_, size_);
+        size_ = 0;
+    }
+
+    // Память уже выделена, метод лишь проверяет, что new_capacity не больше N
+    void Reserve(size_t new_capacity) {
+        CheckCapacity(new_capacity);
+    }
+
+    // Изменяет размер массива.
+    // При увеличении размера новые элементы получают значение по умолчанию для типа Type
+    // Выбрасывает исключение std::length_error, если new_size > N
+    void Resize(size_t new_size) {
+        CheckCapacity(new_size);
+        if (new_size > size_)
+        {
+            std::uninitialized_value_construct(items_ + size_, items_ + new_size);
+        }
+        else
+        {
+            std::destroy(items_ + new_size, items_ + size_);
+        }
+        size_ = new_size;
+    }
+
+    Iterator begin() noexcept {
+        return items_;
+    }
+
+    Iterator end() noexcept {
+        return items_ + size_;
+    }
+
+    ConstIterator begin() const noexcept {
+        return items_;
+    }
+
+    ConstIterator end() const noexcept {
+        return items_ + size_;
+    }
+
+    ConstIterator cbegin() const noexcept {
+        return begin();
+    }
+
+    ConstIterator cend() const noexcept {
+        return end();
+    }
+
+    Span<Type> AsSpan() noexcept {
+        return Span<Type>(items_, size_);
+    }
+
+    ConstSpan<Type> AsSpan() const noexcept {
+        return ConstSpan<Type>(items_, size_);
+    }
+
+    operator Span<Type>() noexcept {
+        return AsSpan();
+    }
+
+    operator ConstSpan<Type>() const noexcept {
+        return AsSpan();
+    }
+
+    // Добавляет элемент в конец вектора
+    // Выбрасывает исключение std::length_error, если вектор заполнен
+    void PushBack(const Type& item) {
+        CheckCapacity(size_ + 1);
+        new (items_ + size_) Type(item);
+        size_++;
+    }
+
+    void PushBack(Type&& item) {
+        CheckCapacity(size_ + 1);
+        new (items_ + size_) Type(std::move(item));
+        size_++;
+    }
+
+    // Вставляет значение value в позицию pos.
+    // Возвращает итератор на вставленное значение
+    // Выбрасывает исключение std::length_error, если вектор заполнен
+    Iterator Insert(ConstIterator pos, Type&& value) {
+        assert(pos >= begin() && pos <= end());
+        CheckCapacity(size_ + 1);
+        const size_t index = static_cast<size_t>(pos - items_);
+        // value может ссылаться на элемент этого же вектора, который сдвиг перезапишет
+        Type item(std::move(value));
+        if (index == size_)
+        {
+            new (items_ + size_) Type(std::move(item));
+        }
+        else
+        {
+            new (items_ + size_) Type(std::move(items_[size_ - 1]));
+            std::move_backward(items_ + index, items_ + size_ - 1, items_ + size_);
+            items_[index] = std::move(item);
+        }
+        size_++;
+        return items_ + index;
+    }
+
+    Iterator Insert(ConstIterator pos, const Type& value) {
+        return Insert(pos, Type(value));
+    }
+
+    // "Удаляет" последний элемент вектора. Вектор не должен быть пустым
+    void PopBack() noexcept {
+        if (!IsEmpty())
+        {
+            size_--;
+            std::destroy_at(items_ + size_);
+        }
+    }
+
+    // Удаляет элемент вектора в указанной позиции
+    Iterator Erase(ConstIterator pos) {
+        assert(pos >= begin() && pos < end());
+        const size_t index = static_cast<size_t>(pos - items_);
+        std::move(items_ + index + 1, items_ + size_, items_ + index);
+        PopBack();
+        return items_ + index;
+    }
+
+    // Обменивает значение с другим вектором
+    void swap(StaticVector& other) noexcept(std::is_nothrow_swappable_v<Type> && std::is_nothrow_move_constructible_v<Type>) {
+        StaticVector& shorter = size_ < other.size_ ? *this : other;
+        StaticVector& longer = size_ < other.size_ ? other : *this;
+        std::swap_ranges(shorter.items_, shorter.items_ + shorter.size_, longer.items_);
+        std::uninitialized_move(longer.items_ + shorter.size_, longer.items_ + longer.size_, shorter.items_ + shorter.size_);
+        std::destroy(longer.items_ + shorter.size_, longer.items_ + longer.size_);
+        std::swap(size_, other.size_);
+    }
+
+private:
+    static void CheckCapacity(size_t size) {
+        if (size > N)
+        {
+            throw std::length_error("capacity exceeded");
+        }
+    }
+
+    // Заменяет содержимое элементами [first, last), переиспользуя уже созданные
+    template <typename It>
+    void Assign(It first, It last) {
+        const size_t new_size = static_cast<size_t>(std::distance(first, last));
+        const size_t common = std::min(size_, new_size);
+        It middle = std::next(first, common);
+        std::copy(first, middle, items_);
+        if (new_size > size_)
+        {
+            std::uninitialized_copy(middle, last, items_ + size_);
+        }
+        else
+        {
+            std::destroy(items_ + new_size, items_ + size_);
+        }
+        size_ = new_size;
+    }
+
+    // Элементы объединения не создаются автоматически:
+    // они конструируются и разрушаются вручную в пределах [0, size_)
+    union {
+        Type items_[N];
+    };
+    size_t size_ = 0;
+};
+
+template <typename Type, size_t N>
+inline bool operator==(const StaticVector<Type, N>& lhs, const StaticVector<Type, N>& rhs) {
+    return (lhs.GetSize() == rhs.GetSize()) && (std::equal(lhs.begin(), lhs.end(), rhs.begin()));
+}
+
+template <typename Type, size_t N>
+inline bool operator!=(const StaticVector<Type, N>& lhs, const StaticVector<Type, N>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <typename Type, size_t N>
+inline bool operator<(const StaticVector<Type, N>& lhs, const StaticVector<Type, N>& rhs) {
+    return (std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()));
+}
+
+template <typename Type, size_t N>
+inline bool operator<=(const StaticVector<Type, N>& lhs, const StaticVector<Type, N>& rhs) {
+    return !(rhs < lhs);
+}
+
+template <typename Type, size_t N>
+inline bool operator>(const StaticVector<Type, N>& lhs, const StaticVector<Type, N>& rhs) {
+    return rhs < lhs;
+}
+
+template <typename Type, size_t N>
+inline bool operator>=(const StaticVector<Type, N>& lhs, const StaticVector<Type, N>& rhs) {
+    return !(lhs < rhs);
+}
@@ -3,9 +3,30 @@
 #include <cassert>
 #include <stdexcept>
 #include "simple_vector.h"
+#include "algorithms.h"
+#include "expressions.h"
+#include "prefetch.h"
+#include "pipeline.h"
+#include "matrix.h"
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+#include "static_vector.h"
+#endif
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include "generator.h"
+#endif
+#include <limits>
 #include <numeric>
+#include <random>
+#include <string>
+#include <unordered_set>
 #include <utility>
 
+#if SIMPLE_VECTOR_HARDENED && defined(__unix__)
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 // У функции, объявленной со спецификатором inline, может быть несколько
 // идентичных определений в разных единицах трансляции.
 // Обычно inline помечают функции, чьё тело находится в заголовочном файле,
@@ -429,3 +450,945 @@ void TestNoncoiableResize()
     assert(flag);
     cout << "Done!" << endl << endl;
 }
+
+void TestSortAndSearch() {
+    using namespace std;
+    cout << "Test sort and search" << endl;
+    mt19937 generator(42);
+    {
+        SimpleVector<int> v(10000);
+        for (int& item : v) {
+            item = static_cast<int>(generator() % 2000000000) - 1000000000;
+        }
+        SimpleVector<int> expected(v);
+        sort(expected.begin(), expected.end());
+        Sort(v);
+        assert(v == expected);
+        assert(*LowerBound(v, v[5000]) == v[5000]);
+        assert(LowerBound(v, v[9999] + 1) == v.end());
+    }
+    {
+        SimpleVector<double> v(1000);
+        for (double& item : v) {
+            item = uniform_real_distribution<double>(-100.0, 100.0)(generator);
+        }
+        SortBuffer<double> buffer;
+        Sort(v, buffer);
+        assert(is_sorted(v.begin(), v.end()));
+        assert(buffer.GetCapacity() == v.GetSize());
+    }
+    {
+        // Устойчивость параллельной сортировки слиянием
+        SimpleVector<pair<int, int>> v(kParallelSortThreshold * 4);
+        for (size_t i = 0; i < v.GetSize(); ++i) {
+            v[i] = {static_cast<int>(generator() % 100), static_cast<int>(i)};
+        }
+        StableSort(v, [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        assert(is_sorted(v.begin(), v.end()));
+    }
+    {
+        // Явная глубина, чтобы потоки запускались и на одноядерной машине
+        SimpleVector<pair<int, int>> v(kParallelSortThreshold * 4);
+        for (size_t i = 0; i < v.GetSize(); ++i) {
+            v[i] = {static_cast<int>(generator() % 100), static_cast<int>(i)};
+        }
+        SortBuffer<pair<int, int>> buffer;
+        Span<pair<int, int>> items = v;
+        detail::ParallelMergeSort(items.begin(), items.end(), buffer.Acquire(v.GetSize()),
+                                  [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; }, 2);
+        assert(is_sorted(v.begin(), v.end()));
+    }
+    {
+        // Небольшой вектор сортируется во временной памяти из buffer
+        SimpleVector<pair<int, int>> v(1000);
+        for (size_t i = 0; i < v.GetSize(); ++i) {
+            v[i] = {static_cast<int>(generator() % 10), static_cast<int>(i)};
+        }
+        SortBuffer<pair<int, int>> buffer;
+        StableSort(v, [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; }, buffer);
+        assert(is_sorted(v.begin(), v.end()));
+        assert(buffer.GetCapacity() == v.GetSize() / 2);
+    }
+    {
+        SimpleVector<int> v{5, 1, 4, 2, 3};
+        NthElement(v, 2);
+        assert(v[2] == 3);
+        assert(LowerBound(SimpleVector<int>{}, 1) == nullptr);
+        SimpleVector<int> sorted{1, 2, 2, 2, 5};
+        assert(LowerBound(sorted, 2) - sorted.begin() == 1);
+        assert(LowerBound(sorted, 0) == sorted.begin());
+    }
+    cout << "Done!" << endl << endl;
+}
+
+void TestExpressions() {
+    using namespace std;
+    cout << "Test lazy expressions" << endl;
+    {
+        SimpleVector<double> a{1.0, 2.0, 3.0};
+        SimpleVector<double> b{10.0, 20.0, 30.0};
+        SimpleVector<double> c = a * 2.0 + b;
+        assert((c == SimpleVector<double>{12.0, 24.0, 36.0}));
+        // Результат пишется поверх c без выделения памяти
+        const double* old_begin = &c[0];
+        c = (c - b) / 2.0;
+        assert(&c[0] == old_begin);
+        assert(c == a);
+        c = Map(a, [](double x) { return x * x; }) + 1.0;
+        assert((c == SimpleVector<double>{2.0, 5.0, 10.0}));
+        assert(Sum(a) == 6.0);
+        assert(Dot(a, b) == 140.0);
+        assert(Sum(a + b) == 66.0);
+    }
+    {
+        const size_t size = kParallelEvaluateThreshold * 2 + 3;
+        SimpleVector<double> a(size, 1.5);
+        SimpleVector<double> b(size, 0.5);
+        SimpleVector<double> c;
+        c.Assign(a * 2.0 + b, true);
+        assert(c.GetSize() == size);
+        assert(all_of(c.begin(), c.end(), [](double x) { return x == 3.5; }));
+
+        // Исключение в текущем или рабочем потоке выбрасывается из Assign
+        // только после завершения всех рабочих потоков
+        for (size_t bad_index : {size_t{0}, size - 1}) {
+            SimpleVector<double> d(size, 1.0);
+            d[bad_index] = -1.0;
+            try {
+                c.Assign(Map(d, [](double x) -> double {
+                    if (x < 0.0) {
+                        throw runtime_error("map failed");
+                    }
+                    return x;
+                }), true);
+                assert(false);
+            } catch (const runtime_error&) {
+            }
+        }
+    }
+    {
+        // Число потоков задаётся явно, чтобы проверить разбиение
+        // на несколько частей независимо от числа ядер машины
+        const SimpleVector<int> a{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        for (unsigned threads : {3u, 4u, 16u}) {
+            SimpleVector<int> out(a.GetSize());
+            detail::EvaluateInto(a * 2 + 1, &out[0], threads);
+            for (size_t i = 0; i < a.GetSize(); ++i) {
+                assert(out[i] == a[i] * 2 + 1);
+            }
+        }
+        for (size_t bad_index : {size_t{0}, size_t{5}, size_t{9}}) {
+            SimpleVector<int> out(a.GetSize());
+            try {
+                detail::EvaluateInto(Map(a, [bad_index](int x) {
+                    if (static_cast<size_t>(x - 1) == bad_index) {
+                        throw runtime_error("map failed");
+                    }
+                    return x;
+                }), &out[0], 4u);
+                assert(false);
+            } catch (const runtime_error&) {
+            }
+        }
+    }
+    cout << "Done!" << endl << endl;
+}
+
+inline int SumSpan(ConstSpan<int> span) {
+    return std::accumulate(span.begin(), span.end(), 0);
+}
+
+void TestSpan() {
+    using namespace std;
+    cout << "Test span" << endl;
+    {
+        SimpleVector<int> v{0, 1, 2, 3, 4, 5, 6, 7};
+        Span<int> span = v;
+        assert(span.GetData() == &v[0]);
+        assert(span.GetSize() == v.GetSize());
+        assert(SumSpan(v) == 28);
+        assert(SumSpan(span.Subspan(2, 3)) == 2 + 3 + 4);
+        assert(SumSpan(span.Subspan(6)) == 6 + 7);
+        assert(SumSpan(span.First(2)) == 1);
+        assert(SumSpan(span.Last(1)) == 7);
+        assert(span.First(0).IsEmpty());
+
+        // Запись через представление меняет сам вектор
+        span.Subspan(1, 2)[0] = 42;
+        assert(v[1] == 42);
+
+        StridedSpan<int> even = span.Stride(2);
+        assert(even.GetSize() == 4);
+        assert(even[3] == 6);
+        assert(accumulate(even.begin(), even.end(), 0) == 0 + 2 + 4 + 6);
+        assert(span.Stride(3).GetSize() == 3);
+        // Длина не кратна шагу: обход останавливается на последнем элементе
+        StridedSpan<int> every_third = span.Stride(3);
+        assert(distance(every_third.begin(), every_third.end()) == 3);
+        int last = -1;
+        for (int item : every_third) {
+            last = item;
+        }
+        assert(last == span[6]);
+
+        const SimpleVector<int>& const_v = v;
+        ConstSpan<int> const_span = const_v.AsSpan();
+        assert(const_span.GetData() == &const_v[0]);
+    }
+    {
+        // Внешний буфер оборачивается без копирования и освобождается своим deleter
+        static int freed = 0;
+        int* buffer = static_cast<int*>(malloc(3 * sizeof(int)));
+        buffer[0] = 1;
+        buffer[1] = 2;
+        buffer[2] = 3;
+        {
+            ArrayPtr<int> items(buffer, [](int* ptr, void* context) {
+                ++*static_cast<int*>(context);
+                free(ptr);
+            }, &freed);
+            assert(items.IsAdopted());
+            SimpleVector<int> v(std::move(items), 3);
+            assert(&v[0] == buffer);
+            assert((v == SimpleVector<int>{1, 2, 3}));
+            v.Resize(10);
+            assert(freed == 1);
+            assert(SumSpan(v.AsSpan().First(3)) == 6);
+        }
+        assert(freed == 1);
+
+        int stack_buffer[2] = {5, 6};
+        {
+            SimpleVector<int> v(ArrayPtr<int>(stack_buffer, nullptr), 2);
+            assert(SumSpan(v) == 11);
+        }
+        assert(stack_buffer[1] == 6);
+    }
+    cout << "Done!" << endl << endl;
+}
+
+#if SIMPLE_VECTOR_HARDENED && defined(__unix__)
+// Выполняет action в дочернем процессе и проверяет, что тот завершился аварийно
+template <typename Action>
+void AssertDies(Action action) {
+    std::cout.flush();
+    const pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0)
+    {
+        // Диагностика ожидаемого падения не нужна в выводе тестов
+        const int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDERR_FILENO);
+        action();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    assert(!(WIFEXITED(status) && WEXITSTATUS(status) == 0));
+}
+#endif
+
+void TestHardenedMode() {
+    using namespace std;
+    cout << "Test hardened mode" << endl;
+#if SIMPLE_VECTOR_HARDENED
+#if defined(__unix__)
+    // Итератор, полученный до перевыделения памяти
+    AssertDies([] {
+        SimpleVector<int> v{1};
+        auto it = v.begin();
+        v.PushBack(2);
+        volatile int value = *it;
+        (void)value;
+    });
+    // Индекс за пределами размера, но в пределах вместимости
+    AssertDies([] {
+        SimpleVector<int> v(Reserve(8));
+        v.PushBack(1);
+        volatile int value = v[3];
+        (void)value;
+    });
+    // Удаление позиции end()
+    AssertDies([] {
+        SimpleVector<int> v{1, 2};
+        v.Erase(v.cend());
+    });
+    // Индекс удаления за пределами размера
+    AssertDies([] {
+        SimpleVector<int> v{1, 2, 3};
+        SimpleVector<size_t> indices{1, 3};
+        v.RemoveIndices(indices);
+    });
+    // Индексы удаления не по возрастанию
+    AssertDies([] {
+        SimpleVector<int> v{1, 2, 3};
+        SimpleVector<size_t> indices{2, 0};
+        v.RemoveIndices(indices);
+    });
+#ifdef SIMPLE_VECTOR_ANNOTATE
+    // Обращение к [size, capacity) в обход проверок видит AddressSanitizer
+    AssertDies([] {
+        SimpleVector<int> v(Reserve(8));
+        v.PushBack(1);
+        volatile int value = v.AsSpan().GetData()[4];
+        (void)value;
+    });
+#endif
+#endif
+    {
+        // PopBack и запись по индексу не делают итераторы недействительными
+        SimpleVector<int> v{1, 2, 3};
+        auto it = v.begin();
+        v.PopBack();
+        v[1] = 42;
+        assert(*it == 1);
+        assert(it[1] == 42);
+        SimpleVector<int>::ConstIterator const_it = it;
+        assert(const_it == v.cbegin());
+    }
+#else
+    // Без усиленного режима итераторы остаются обычными указателями
+    static_assert(is_same_v<SimpleVector<int>::Iterator, int*>);
+    static_assert(is_same_v<SimpleVector<int>::ConstIterator, const int*>);
+#endif
+    {
+        // Вставка и удаление в пределах вместимости не перевыделяют память
+        SimpleVector<int> v(Reserve(8));
+        v.PushBack(1);
+        v.PushBack(3);
+        const int* data = &v[0];
+        v.Insert(v.begin() + 1, 2);
+        v.Insert(v.end(), 4);
+        assert((v == SimpleVector<int>{1, 2, 3, 4}));
+        assert(&v[0] == data);
+        assert(v.GetCapacity() == 8);
+        auto it = v.Erase(v.begin() + 1);
+        assert(*it == 3);
+        it = v.Erase(v.end() - 1);
+        assert(it == v.end());
+        assert((v == SimpleVector<int>{1, 3}));
+        assert(&v[0] == data);
+    }
+    {
+        // Добавляемое значение - элемент того же заполненного вектора
+        SimpleVector<int> v{7};
+        v.PushBack(v[0]);
+        assert((v == SimpleVector<int>{7, 7}));
+        SimpleVector<string> words{"alpha"s, "beta"s};
+        words.PushBack(words[0]);
+        words.PushBack(move(words[1]));
+        assert(words.GetSize() == 4);
+        assert(words[2] == "alpha"s && words[3] == "beta"s);
+        SimpleVector<string> names{"x"s};
+        names.Insert(names.begin(), move(names[0]));
+        assert(names.GetSize() == 2 && names[0] == "x"s);
+    }
+    cout << "Done!" << endl << endl;
+}
+
+#if defined(__cpp_constexpr_dynamic_alloc) && __cpp_constexpr_dynamic_alloc >= 201907L && !SIMPLE_VECTOR_HARDENED && !SIMPLE_VECTOR_MEMORY_STATS
+// Память, выделенная SimpleVector, освобождается до конца вычисления,
+// поэтому результат можно получить на этапе компиляции
+constexpr int SumOfSquares(int count) {
+    SimpleVector<int> v;
+    for (int i = 0; i < count; ++i) {
+        v.PushBack(i * i);
+    }
+    v.Insert(v.begin(), 1000);
+    v.Erase(v.begin());
+    SimpleVector<int> copy = v;
+    copy.Resize(copy.GetSize() + 3);
+    int sum = 0;
+    for (int item : copy) {
+        sum += item;
+    }
+    return copy == v ? -1 : sum;
+}
+static_assert(SumOfSquares(10) == 285);
+
+// Таблица строится при компиляции и хранится в программе как обычный массив
+constexpr auto kPrimesBelow50 = ToArray<15>([] {
+    SimpleVector<bool> composite(50, false);
+    SimpleVector<int> primes;
+    for (int i = 2; i < 50; ++i) {
+        if (!composite[i])
+        {
+            primes.PushBack(i);
+            for (int j = i * i; j < 50; j += i) {
+                composite[j] = true;
+            }
+        }
+    }
+    return primes;
+});
+static_assert(kPrimesBelow50.size() == 15);
+static_assert(kPrimesBelow50[0] == 2 && kPrimesBelow50[14] == 47);
+#endif
+
+void TestConstexprTables() {
+    using namespace std;
+    cout << "Test constexpr tables" << endl;
+    {
+        // ToArray работает и во время выполнения, в том числе в усиленном режиме
+        const auto squares = ToArray<4>([] {
+            SimpleVector<int> v;
+            for (int i = 0; i < 4; ++i) {
+                v.PushBack(i * i);
+            }
+            return v;
+        });
+        assert((squares == array<int, 4>{0, 1, 4, 9}));
+        try {
+            ToArray<3>([] { return SimpleVector<int>(2); });
+            assert(false);
+        } catch (const length_error&) {
+        }
+    }
+    cout << "Done!" << endl << endl;
+}
+
+void TestStaticVector() {
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+    using namespace std;
+    cout << "Test static vector" << endl;
+    static_assert(is_trivially_copyable_v<StaticVector<int, 4>>);
+    static_assert(!is_trivially_copyable_v<StaticVector<X, 4>>);
+    static_assert(sizeof(StaticVector<int, 4>) == 4 * sizeof(int) + sizeof(size_t));
+    {
+        StaticVector<int, 8> v{1, 2, 4};
+        assert(v.GetCapacity() == 8);
+        v.Insert(v.begin() + 2, 3);
+        v.PushBack(5);
+        assert((v == StaticVector<int, 8>{1, 2, 3, 4, 5}));
+        v.Erase(v.begin());
+        assert((v == StaticVector<int, 8>{2, 3, 4, 5}));
+        v.Resize(6);
+        assert(v[5] == 0);
+        assert((StaticVector<int, 8>{1, 2} < v));
+        StaticVector<int, 8> copy = v;
+        assert(copy == v);
+        try {
+            v.Resize(9);
+            assert(false);
+        } catch (const length_error&) {
+        }
+    }
+    {
+        StaticVector<X, 5> v;
+        for (size_t i = 0; i < 3; ++i) {
+            v.PushBack(X(i));
+        }
+        v.Insert(v.begin(), X(10));
+        assert(v.begin()->GetX() == 10);
+        auto it = v.Erase(v.begin() + 1);
+        assert(it->GetX() == 1);
+        StaticVector<X, 5> moved = move(v);
+        assert(moved.GetSize() == 3);
+        StaticVector<X, 5> other;
+        other.PushBack(X(7));
+        other.swap(moved);
+        assert(other.GetSize() == 3 && moved.GetSize() == 1);
+        assert(moved[0].GetX() == 7 && other[2].GetX() == 2);
+        other.Clear();
+        assert(other.IsEmpty());
+    }
+    {
+        // Вставка элемента того же вектора, который сдвиг перезапишет
+        StaticVector<string, 4> v{"x", "y"};
+        v.Insert(v.begin(), move(v[1]));
+        assert((v == StaticVector<string, 4>{"y", "x", ""}));
+        v.Insert(v.begin() + 1, v[0]);
+        assert((v == StaticVector<string, 4>{"y", "y", "x", ""}));
+    }
+    cout << "Done!" << endl << endl;
+#endif
+}
+
+void TestBatchErase() {
+    using namespace std;
+    cout << "Test batch erase" << endl;
+    {
+        SimpleVector<int> v{1, 2, 3, 4, 5, 6, 7, 8};
+        const size_t old_capacity = v.GetCapacity();
+        const int* data = &v[0];
+        assert(v.EraseIf([](int x) { return x % 2 == 0; }) == 4);
+        assert((v == SimpleVector<int>{1, 3, 5, 7}));
+        assert(v.GetCapacity() == old_capacity);
+        assert(&v[0] == data);
+        assert(v.EraseIf([](int x) { return x > 100; }) == 0);
+    }
+    {
+        SimpleVector<int> v{1, 1, 2, 2, 2, 3, 1, 1};
+        assert(v.Unique() == 4);
+        assert((v == SimpleVector<int>{1, 2, 3, 1}));
+    }
+    {
+        SimpleVector<int> v{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+        SimpleVector<size_t> indices{0, 3, 4, 9};
+        assert(v.RemoveIndices(indices) == 4);
+        assert((v == SimpleVector<int>{1, 2, 5, 6, 7, 8}));
+        assert(v.RemoveIndices(SimpleVector<size_t>{}) == 0);
+    }
+    {
+        SimpleVector<X> v;
+        for (size_t i = 0; i < 10; ++i) {
+            v.PushBack(X(i));
+        }
+        auto middle = v.StablePartition([](const X& x) { return x.GetX() % 3 == 0; });
+        assert(middle - v.begin() == 4);
+        const size_t expected[] = {0, 3, 6, 9, 1, 2, 4, 5, 7, 8};
+        for (size_t i = 0; i < v.GetSize(); ++i) {
+            assert(v[i].GetX() == expected[i]);
+        }
+    }
+    {
+        mt19937 generator(7);
+        const size_t size = 1000;
+        SimpleVector<uint32_t> v(size);
+        SimpleVector<uint8_t> mask(size);
+        SimpleVector<uint32_t> expected;
+        for (size_t i = 0; i < size; ++i) {
+            v[i] = generator();
+            mask[i] = generator() % 3 == 0;
+            if (mask[i]) {
+                expected.PushBack(v[i]);
+            }
+        }
+        SimpleVector<double> d(size);
+        iota(d.begin(), d.end(), 0.0);
+        assert(CompactByMask(v, mask) == size - expected.GetSize());
+        assert(v == expected);
+        CompactByMask(d, mask);
+        assert(d.GetSize() == expected.GetSize());
+        assert(is_sorted(d.begin(), d.end()));
+    }
+    cout << "Done!" << endl << endl;
+}
+
+void TestPrefetchTraversal() {
+    using namespace std;
+    cout << "Test prefetch traversal" << endl;
+    const size_t size = 10000;
+    SimpleVector<uint64_t> source(size);
+    iota(source.begin(), source.end(), 0);
+    SimpleVector<size_t> indices(size / 2);
+    mt19937 generator(3);
+    for (size_t& index : indices) {
+        index = generator() % size;
+    }
+    {
+        SimpleVector<uint64_t> out;
+        GatherInto(source, indices, out);
+        assert(out.GetSize() == indices.GetSize());
+        for (size_t i = 0; i < indices.GetSize(); ++i) {
+            assert(out[i] == indices[i]);
+        }
+        // Расстояние больше количества индексов
+        SimpleVector<size_t> few{5, 1};
+        GatherInto(source, few, out, 64);
+        assert((out == SimpleVector<uint64_t>{5, 1}));
+    }
+    {
+        size_t calls = 0;
+        ForEachIndexed(source, indices, [&](size_t index, uint64_t value) {
+            assert(index == indices[calls]);
+            assert(value == index);
+            ++calls;
+        }, 4);
+        assert(calls == indices.GetSize());
+    }
+    {
+        uint64_t sum = 0;
+        for (const uint64_t& item : WithPrefetch(static_cast<const SimpleVector<uint64_t>&>(source))) {
+            sum += item;
+        }
+        assert(sum == size * (size - 1) / 2);
+        for (uint64_t& item : WithPrefetch(source, 8)) {
+            item = 1;
+        }
+        assert(accumulate(source.begin(), source.end(), uint64_t{0}) == size);
+    }
+    {
+        // Предвыборка при входе в обход не выходит за пределы коротких векторов
+        SimpleVector<int> empty;
+        for (int& item : WithPrefetch(empty)) {
+            (void)item;
+            assert(false);
+        }
+        SimpleVector<int> short_vector{1, 2, 3};
+        for (size_t distance : {size_t{0}, size_t{2}, size_t{3}, numeric_limits<size_t>::max()}) {
+            int sum = 0;
+            for (int item : WithPrefetch(short_vector, distance)) {
+                sum += item;
+            }
+            assert(sum == 6);
+        }
+    }
+    cout << "Done!" << endl << endl;
+}
+
+void TestMemoryAccounting() {
+    using namespace std;
+    cout << "Test memory accounting" << endl;
+    {
+        SimpleVector<int> v(Reserve(100));
+        v.PushBack(1);
+        v.PushBack(2);
+        SimpleVector<int> copy(v);
+        assert(copy.GetCapacity() == 2);
+        copy = v;
+        assert(copy.GetCapacity() == 2);
+        v.ShrinkToFit();
+        assert(v.GetCapacity() == 2);
+        assert((v == SimpleVector<int>{1, 2}));
+        v.Clear();
+        v.ShrinkToFit();
+        assert(v.GetCapacity() == 0);
+        assert(v.begin() == nullptr);
+    }
+#if SIMPLE_VECTOR_MEMORY_STATS
+    {
+        const VectorMemoryStats before = GetVectorMemoryStats();
+        SimpleVector<int> full{1, 2, 3, 4};
+        SimpleVector<int> sparse(Reserve(10));
+        sparse.PushBack(1);
+        SimpleVector<SimpleVector<int>> nested(3);
+        nested[0].Reserve(8);
+        {
+            const VectorMemoryStats stats = GetVectorMemoryStats();
+            // full, sparse, nested и nested[0]: пустые вложенные векторы памяти не занимают
+            assert(stats.live_vectors == before.live_vectors + 4);
+            assert(stats.used_bytes - before.used_bytes == 5 * sizeof(int) + 3 * sizeof(SimpleVector<int>));
+            assert(stats.reserved_bytes - before.reserved_bytes ==
+                   22 * sizeof(int) + 3 * sizeof(SimpleVector<int>));
+            assert(stats.fill_ratio_histogram[9] - before.fill_ratio_histogram[9] == 2);
+            assert(stats.fill_ratio_histogram[1] - before.fill_ratio_histogram[1] == 1);
+            assert(stats.fill_ratio_histogram[0] - before.fill_ratio_histogram[0] == 1);
+        }
+        nested.PushBack(SimpleVector<int>(Reserve(4)));
+        assert(TrimAll() >= 21 * sizeof(int));
+        assert(sparse.GetCapacity() == 1);
+        assert(nested[0].GetCapacity() == 0);
+        assert(nested.GetCapacity() == 4);
+        const VectorMemoryStats after = GetVectorMemoryStats();
+        assert(after.used_bytes == after.reserved_bytes);
+    }
+    {
+        // Элементы неиспользуемой части буфера живыми векторами не считаются
+        SimpleVector<SimpleVector<int>> v(Reserve(100));
+        assert(GetVectorMemoryStats().live_vectors == 1);
+        v.PushBack(SimpleVector<int>{1, 2});
+        v.PushBack(SimpleVector<int>{3});
+        assert(GetVectorMemoryStats().live_vectors == 3);
+        // Удалённый элемент сразу освобождает память
+        v.PopBack();
+        assert(GetVectorMemoryStats().live_vectors == 2);
+        v.Clear();
+        const VectorMemoryStats stats = GetVectorMemoryStats();
+        assert(stats.live_vectors == 1);
+        assert(stats.used_bytes == 0);
+        assert(stats.reserved_bytes == 100 * sizeof(SimpleVector<int>));
+    }
+    assert(GetVectorMemoryStats().live_vectors == 0);
+#endif
+    cout << "Done!" << endl << endl;
+}
+
+void TestHash() {
+    using namespace std;
+    cout << "Test hash" << endl;
+    {
+        for (size_t size : {0, 1, 7, 8, 31, 32, 33, 100}) {
+            SimpleVector<uint8_t> v(size);
+            iota(v.begin(), v.end(), uint8_t{1});
+            SimpleVector<uint8_t> same(v);
+            assert(v.Hash() == same.Hash());
+            if (size > 0) {
+                same[size - 1]++;
+                assert(v.Hash() != same.Hash());
+            }
+        }
+        // Размер участвует в хеше, даже если байты нулевые
+        assert(SimpleVector<uint8_t>(3).Hash() != SimpleVector<uint8_t>(4).Hash());
+    }
+    {
+        unordered_set<SimpleVector<int>> keys;
+        keys.insert(SimpleVector<int>{1, 2, 3});
+        keys.insert(SimpleVector<int>{1, 2, 3});
+        keys.insert(SimpleVector<int>{3, 2, 1});
+        assert(keys.size() == 2);
+        assert(keys.count(SimpleVector<int>{3, 2, 1}) == 1);
+    }
+    {
+        // Числа с плавающей точкой хешируются поэлементно: 0.0 == -0.0
+        assert((SimpleVector<double>{0.0, 1.5}.Hash() == SimpleVector<double>{-0.0, 1.5}.Hash()));
+    }
+    {
+        HashedVector<int> key(SimpleVector<int>{4, 5, 6});
+        HashedVector<int> same_key(SimpleVector<int>{4, 5, 6});
+        HashedVector<int> other_key(SimpleVector<int>{4, 5, 7});
+        assert(key.Hash() == key.Get().Hash());
+        assert(key == same_key);
+        assert(key != other_key);
+        unordered_set<HashedVector<int>> keys{key, same_key, other_key};
+        assert(keys.size() == 2);
+    }
+    cout << "Done!" << endl << endl;
+}
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+Generator<int> CountTo(int count) {
+    co_yield Reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        co_yield i;
+    }
+}
+
+Generator<int> ThrowAfter(int count) {
+    for (int i = 0; i < count; ++i) {
+        co_yield i;
+    }
+    throw std::runtime_error("generator failed");
+}
+#endif
+
+void TestGenerator() {
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+    using namespace std;
+    cout << "Test generator" << endl;
+    {
+        int expected = 0;
+        for (int value : CountTo(5)) {
+            assert(value == expected++);
+        }
+        assert(expected == 5);
+    }
+    {
+        // Подсказка из сопрограммы резервирует память сразу под все значения
+        SimpleVector<int> v = Collect(CountTo(1000));
+        assert(v.GetSize() == 1000);
+        assert(v.GetCapacity() == 1000);
+        assert(v[999] == 999);
+    }
+    {
+        SimpleVector<int> v{-1};
+        Generator<int> generator = CountTo(3);
+        AppendTo(generator, v);
+        assert((v == SimpleVector<int>{-1, 0, 1, 2}));
+        assert(!generator.Next());
+    }
+    {
+        SimpleVector<int> v;
+        Generator<int> generator = ThrowAfter(2);
+        try {
+            AppendTo(generator, v);
+            assert(false);
+        } catch (const runtime_error&) {
+        }
+        assert(v.GetSize() == 2);
+    }
+    cout << "Done!" << endl << endl;
+#endif
+}
+
+void TestBatchPipeline() {
+    using namespace std;
+    cout << "Test batch pipeline" << endl;
+    const int count = 10007;
+    {
+        BatchPipeline<int> pipeline(3, 64);
+        int next = 0;
+        long long sum = 0;
+        int expected = 0;
+        unordered_set<const int*> buffers;
+        pipeline.Run(
+            [&](SimpleVector<int>& batch) {
+                assert(batch.IsEmpty());
+                while (next < count && batch.GetSize() < pipeline.GetBatchCapacity()) {
+                    batch.PushBack(next++);
+                }
+                return next < count;
+            },
+            [&](SimpleVector<int>& batch) {
+                // Пакеты приходят по порядку и не перераспределяют память
+                buffers.insert(batch.AsSpan().GetData());
+                assert(batch.GetCapacity() == pipeline.GetBatchCapacity());
+                for (int value : batch) {
+                    assert(value == expected++);
+                    sum += value;
+                }
+            });
+        assert(expected == count);
+        assert(sum == static_cast<long long>(count) * (count - 1) / 2);
+        assert(buffers.size() <= pipeline.GetBatchCount());
+
+        // Повторный запуск использует те же пакеты
+        size_t batches = 0;
+        pipeline.Run(
+            [](SimpleVector<int>& batch) {
+                batch.PushBack(1);
+                return false;
+            },
+            [&](SimpleVector<int>& batch) {
+                assert(buffers.count(batch.AsSpan().GetData()) == 1);
+                ++batches;
+            });
+        assert(batches == 1);
+    }
+    {
+        BatchPipeline<int> pipeline(2, 4);
+        try {
+            pipeline.Run(
+                [](SimpleVector<int>& batch) {
+                    batch.PushBack(1);
+                    return true;
+                },
+                [](SimpleVector<int>&) {
+                    throw runtime_error("consumer failed");
+                });
+            assert(false);
+        } catch (const runtime_error& e) {
+            assert(string(e.what()) == "consumer failed");
+        }
+        int produced = 0;
+        try {
+            pipeline.Run(
+                [&](SimpleVector<int>& batch) -> bool {
+                    if (++produced == 3)
+                    {
+                        throw runtime_error("producer failed");
+                    }
+                    batch.PushBack(produced);
+                    return true;
+                },
+                [](SimpleVector<int>&) {
+                });
+            assert(false);
+        } catch (const runtime_error& e) {
+            assert(string(e.what()) == "producer failed");
+        }
+
+        // После прерванных запусков конвейер снова пропускает все пакеты
+        int next = 0;
+        int consumed = 0;
+        pipeline.Run(
+            [&](SimpleVector<int>& batch) {
+                batch.PushBack(next++);
+                return next < 10;
+            },
+            [&](SimpleVector<int>& batch) {
+                assert(batch[0] == consumed++);
+            });
+        assert(consumed == 10);
+    }
+    {
+        // Заполненную очередь можно сбросить и заполнить заново, как в начале Run
+        detail::BatchQueue queue(3);
+        for (size_t i = 0; i < 3; ++i) {
+            queue.Push(i);
+        }
+        assert(queue.Pop() == 0);
+        queue.Push(3);
+        queue.Clear();
+        assert(queue.IsEmpty());
+        for (size_t i = 0; i < 3; ++i) {
+            queue.Push(i + 10);
+        }
+        for (size_t i = 0; i < 3; ++i) {
+            assert(queue.Pop() == i + 10);
+        }
+        assert(queue.IsEmpty());
+    }
+    cout << "Done!" << endl << endl;
+}
+
+void TestMatrix() {
+    using namespace std;
+    cout << "Test matrix" << endl;
+    {
+        Matrix<int> m(2, 3);
+        m(0, 1) = 1;
+        m(1, 2) = 5;
+        assert((m.GetStorage() == SimpleVector<int>{0, 1, 0, 0, 0, 5}));
+        Matrix<int> by_cols(2, 3, MatrixLayout::ColumnMajor);
+        by_cols(0, 1) = 1;
+        by_cols(1, 2) = 5;
+        assert((by_cols.GetStorage() == SimpleVector<int>{0, 0, 1, 0, 0, 5}));
+        assert(m == by_cols);
+        assert(m.Col(2).GetSize() == 2 && m.Col(2)[0] == 0 && m.Col(2)[1] == 5);
+        assert(by_cols.Row(0).GetStride() == 2 && by_cols.Row(0)[1] == 1);
+        ConstMatrixView<int> transposed = m.View().Transposed();
+        assert(transposed.GetRows() == 3 && transposed(2, 1) == 5);
+        assert(m.View().Block(1, 1, 1, 2)(0, 1) == 5);
+    }
+    {
+        // Каждая строка дополнена до 64 байт и начинается с выровненного адреса
+        Matrix<float> m(5, 17, 1.0f, MatrixLayout::RowMajor, true);
+        assert(m.GetLeadingDimension() == 32);
+        for (size_t row = 0; row < m.GetRows(); ++row) {
+            assert(reinterpret_cast<uintptr_t>(&m(row, 0)) % kMatrixAlignment == 0);
+        }
+        Matrix<float> copy(m);
+        assert(reinterpret_cast<uintptr_t>(&copy(1, 0)) % kMatrixAlignment == 0);
+        assert(copy == m);
+        Matrix<float> moved(move(copy));
+        assert(moved == m && copy.GetRows() == 0);
+        // Дополнение не входит в суммы
+        assert((RowSums(m) == SimpleVector<float>(5, 17.0f)));
+        assert((ColSums(m) == SimpleVector<float>(17, 5.0f)));
+    }
+    for (MatrixLayout source_layout : {MatrixLayout::RowMajor, MatrixLayout::ColumnMajor}) {
+        for (MatrixLayout target_layout : {MatrixLayout::RowMajor, MatrixLayout::ColumnMajor}) {
+            const size_t rows = 37;
+            const size_t cols = 70;
+            Matrix<int> m(rows, cols, source_layout, true);
+            for (size_t row = 0; row < rows; ++row) {
+                for (size_t col = 0; col < cols; ++col) {
+                    m(row, col) = static_cast<int>(row * 1000 + col);
+                }
+            }
+            Matrix<int> t(cols, rows, target_layout);
+            Transpose(m.View(), t.View());
+            for (size_t row = 0; row < rows; ++row) {
+                for (size_t col = 0; col < cols; ++col) {
+                    assert(t(col, row) == m(row, col));
+                }
+            }
+            assert(Transpose(Transpose(m)) == m);
+
+            SimpleVector<int> row_sums = RowSums(m);
+            SimpleVector<int> col_sums = ColSums(m);
+            for (size_t row = 0; row < rows; ++row) {
+                assert(row_sums[row] == static_cast<int>(row * 1000 * cols + cols * (cols - 1) / 2));
+            }
+            assert(col_sums == RowSums(t));
+            SimpleVector<int> col_max = ReduceCols(m.View(), 0, [](int lhs, int rhs) {
+                return max(lhs, rhs);
+            });
+            assert(col_max[5] == static_cast<int>((rows - 1) * 1000 + 5));
+        }
+    }
+    {
+        Matrix<int> m(10, 7);
+        size_t tiles = 0;
+        ForEachTile(m.View(), 4, 3, [&tiles](MatrixView<int> tile, size_t row, size_t col) {
+            assert(tile.GetRows() == min<size_t>(4, 10 - row));
+            assert(tile.GetCols() == min<size_t>(3, 7 - col));
+            for (size_t i = 0; i < tile.GetRows(); ++i) {
+                for (size_t j = 0; j < tile.GetCols(); ++j) {
+                    tile(i, j)++;
+                }
+            }
+            ++tiles;
+        });
+        assert(tiles == 3 * 3);
+        assert((ColSums(m) == SimpleVector<int>(7, 10)));
+        try {
+            Matrix<int> wrong(7, 7);
+            Transpose(m.View(), wrong.View());
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+    }
+    cout << "Done!" << endl << endl;
+}